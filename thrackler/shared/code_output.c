@@ -0,0 +1,165 @@
+/*
+ * Main developer: Nico Van Cleemput
+ * 
+ * Copyright (C) 2014 Nico Van Cleemput.
+ * Licensed under the GNU GPL, read the file LICENSE for details.
+ */
+
+//O_DIRECT is only defined with _GNU_SOURCE
+#define _GNU_SOURCE
+
+#include "code_output.h"
+#include<stdio.h>
+#include<errno.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/uio.h>
+
+#define PAGE_ALIGNMENT 4096
+
+static void outOfMemory(){
+    fprintf(stderr, "Insufficient memory for output buffer -- exiting!\n");
+    exit(EXIT_FAILURE);
+}
+
+static void allocateBuffer(CODEOUTPUT *output, size_t capacity){
+    size_t alignment = output->blockSize % PAGE_ALIGNMENT == 0 ?
+        output->blockSize : sizeof(void *);
+    unsigned char *buffer;
+    
+    //posix_memalign requires a power of two
+    while(alignment & (alignment - 1)){
+        alignment &= alignment - 1;
+    }
+    if(posix_memalign((void **)&buffer, alignment, capacity)){
+        outOfMemory();
+    }
+    if(output->size){
+        memcpy(buffer, output->buffer, output->size);
+    }
+    free(output->buffer);
+    output->buffer = buffer;
+    output->capacity = capacity;
+}
+
+/* Writes all data in the given vectors, also after partial writes.
+ */
+static void writeVectors(int fd, struct iovec *vectors, int count){
+    while(count > 0){
+        ssize_t written = writev(fd, vectors, count);
+        if(written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            perror("write() failed");
+            fprintf(stderr, "Could not write the output -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        while(count > 0 && (size_t)written >= vectors->iov_len){
+            written -= vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if(count > 0){
+            vectors->iov_base = (char *)vectors->iov_base + written;
+            vectors->iov_len -= written;
+        }
+    }
+}
+
+static void writeBuffer(CODEOUTPUT *output, size_t length){
+    struct iovec vector = {output->buffer, length};
+    
+    writeVectors(output->fd, &vector, 1);
+    output->size -= length;
+    memmove(output->buffer, output->buffer + length, output->size);
+}
+
+void openCodeOutput(CODEOUTPUT *output, int fd, size_t blockSize){
+    output->fd = fd;
+    output->blockSize = blockSize;
+    output->size = 0;
+    output->buffer = NULL;
+    allocateBuffer(output, 2 * blockSize);
+}
+
+/* Makes room for at least length more bytes and returns the position after
+ * the bytes that are already in the buffer.
+ */
+unsigned char *reserveCodeOutput(CODEOUTPUT *output, size_t length){
+    if(output->size + length > output->capacity){
+        size_t capacity = output->capacity;
+        while(output->size + length > capacity){
+            capacity *= 2;
+        }
+        allocateBuffer(output, capacity);
+    }
+    return output->buffer + output->size;
+}
+
+/* Writes all complete blocks in the buffer and keeps the remainder.
+ */
+void writeCodeOutputBlocks(CODEOUTPUT *output){
+    size_t length = output->size - output->size % output->blockSize;
+    
+    if(length > 0){
+        writeBuffer(output, length);
+    }
+}
+
+/* Adds a block of data that was encoded elsewhere. The data is copied into
+ * the buffer, so that only whole blocks are written from aligned memory.
+ */
+void appendCodeOutput(CODEOUTPUT *output, const void *data, size_t length){
+    while(length > 0){
+        size_t part = length;
+        
+        if(output->fd >= 0){
+            if(output->size >= output->blockSize){
+                writeCodeOutputBlocks(output);
+            }
+            //the buffer holds at least two blocks, so a whole block fits
+            if(part > output->capacity - output->size){
+                part = output->capacity - output->size;
+            }
+        }
+        memcpy(reserveCodeOutput(output, part), data, part);
+        output->size += part;
+        data = (const char *)data + part;
+        length -= part;
+    }
+    if(output->fd >= 0 && output->size >= output->blockSize){
+        writeCodeOutputBlocks(output);
+    }
+}
+
+/* Writes everything in the buffer, including a final partial block. A partial
+ * block cannot be written to a descriptor opened with O_DIRECT, so O_DIRECT is
+ * cleared first. The file offset is then no longer aligned, so the later
+ * output is written without O_DIRECT as well.
+ */
+void flushCodeOutput(CODEOUTPUT *output){
+    if(output->fd < 0 || output->size == 0){
+        return;
+    }
+    writeCodeOutputBlocks(output);
+#ifdef O_DIRECT
+    if(output->size > 0){
+        int flags = fcntl(output->fd, F_GETFL);
+        if(flags >= 0 && (flags & O_DIRECT)){
+            fcntl(output->fd, F_SETFL, flags & ~O_DIRECT);
+        }
+    }
+#endif
+    if(output->size > 0){
+        writeBuffer(output, output->size);
+    }
+}
+
+void closeCodeOutput(CODEOUTPUT *output){
+    flushCodeOutput(output);
+    free(output->buffer);
+    output->buffer = NULL;
+    output->size = output->capacity = 0;
+}
+
@@ -0,0 +1,85 @@
+/*
+ * Main developer: Nico Van Cleemput
+ * 
+ * Copyright (C) 2014 Nico Van Cleemput.
+ * Licensed under the GNU GPL, read the file LICENSE for details.
+ */
+
+#ifndef CODE_OUTPUT_H
+#define	CODE_OUTPUT_H
+
+#include<stdlib.h>
+#include<string.h>
+
+#define DEFAULT_OUTPUT_BLOCK_SIZE (1 << 16)
+
+/* Buffered output for binary codes such as planar_code and thrackle_code.
+ * Records are encoded directly into the buffer, and the buffer is written to
+ * the file descriptor in whole blocks of blockSize bytes. Only the final flush
+ * writes a partial block. The buffer is aligned to the block size when that is
+ * a multiple of the page size, so a descriptor opened with O_DIRECT can be
+ * used with a suitable block size. O_DIRECT is cleared before a partial block
+ * is written.
+ * 
+ * An output with a negative file descriptor is never written and just grows,
+ * which is used to collect output in memory.
+ */
+typedef struct {
+    int fd;
+    size_t blockSize;
+    size_t size; /* the number of bytes in the buffer */
+    size_t capacity;
+    unsigned char *buffer;
+} CODEOUTPUT;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+void openCodeOutput(CODEOUTPUT *output, int fd, size_t blockSize);
+
+unsigned char *reserveCodeOutput(CODEOUTPUT *output, size_t length);
+
+void writeCodeOutputBlocks(CODEOUTPUT *output);
+
+void appendCodeOutput(CODEOUTPUT *output, const void *data, size_t length);
+
+void flushCodeOutput(CODEOUTPUT *output);
+
+void closeCodeOutput(CODEOUTPUT *output);
+
+#ifdef	__cplusplus
+}
+#endif
+
+/* Returns the position in the buffer at which at least length bytes can be
+ * encoded. The encoded bytes are added to the output by finishCodeRecord.
+ */
+static inline unsigned char *startCodeRecord(CODEOUTPUT *output, size_t length){
+    if(output->size + length > output->capacity){
+        return reserveCodeOutput(output, length);
+    }
+    return output->buffer + output->size;
+}
+
+static inline unsigned char *putCodeByte(unsigned char *position, unsigned char value){
+    *position = value;
+    return position + 1;
+}
+
+/* Shorts are written in the byte order of the machine, as with fwrite.
+ */
+static inline unsigned char *putCodeShort(unsigned char *position, unsigned short value){
+    memcpy(position, &value, sizeof(unsigned short));
+    return position + sizeof(unsigned short);
+}
+
+static inline void finishCodeRecord(CODEOUTPUT *output, unsigned char *end){
+    output->size = end - output->buffer;
+    if(output->size >= output->blockSize && output->fd >= 0){
+        writeCodeOutputBlocks(output);
+    }
+}
+
+#endif	/* CODE_OUTPUT_H */
+
@@ -7,6 +7,7 @@
 
 
 #include "multicode_base.h"
+#include<stdio.h>
 
 /* This method adds the edge (v,w) to graph. This assumes that adj contains
  * the current degree of the vertices v and w. This degrees are then updated.
@@ -59,22 +60,47 @@ void removeEdge(GRAPH graph, ADJACENCY adj, int v, int w, boolean all){
     }
 }
 
-void prepareGraph(GRAPH graph, ADJACENCY adj, int vertexCount) {
+/* This method allocates an empty graph with the given number of vertices in
+ * which vertex v can get up to maxDegrees[v] neighbours. All rows are stored
+ * in a single block after the row pointers.
+ */
+void prepareGraph(GRAPH *graph, ADJACENCY *adj, int vertexCount, int *maxDegrees) {
     int i, j;
+    size_t entries = 1;
+    unsigned short *row;
     
-    //mark all vertices as having degree 0
     for (i = 1; i <= vertexCount; i++) {
-        adj[i] = 0;
-        for (j = 0; j <= MAXVAL; j++) {
-            graph[i][j] = EMPTY;
-        }
+        entries += maxDegrees[i] + 1;
     }
-    //clear first row
-    for (j = 1; j <= MAXVAL; j++) {
-        graph[0][j] = 0;
+    
+    *graph = malloc(sizeof(unsigned short *) * (vertexCount + 1) + sizeof(unsigned short) * entries);
+    *adj = malloc(sizeof(unsigned short) * (vertexCount + 1));
+    if (*graph == NULL || *adj == NULL) {
+        fprintf(stderr, "Insufficient memory for graph with %d vertices -- exiting!\n", vertexCount);
+        exit(1);
     }
     
-    graph[0][0] = vertexCount;
+    //first row only contains the number of vertices
+    row = (unsigned short *) (*graph + vertexCount + 1);
+    (*graph)[0] = row;
+    row[0] = vertexCount;
+    row++;
+    
+    //mark all vertices as having degree 0
+    (*adj)[0] = 0;
+    for (i = 1; i <= vertexCount; i++) {
+        (*graph)[i] = row;
+        (*adj)[i] = 0;
+        for (j = 0; j <= maxDegrees[i]; j++) {
+            row[j] = EMPTY;
+        }
+        row += maxDegrees[i] + 1;
+    }
+}
+
+void freeGraph(GRAPH graph, ADJACENCY adj) {
+    free(graph);
+    free(adj);
 }
 
 boolean areAdjacent(GRAPH graph, ADJACENCY adj, int v, int w){
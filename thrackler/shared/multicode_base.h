@@ -11,12 +11,6 @@
 #include<stdlib.h>
 #include<limits.h>
 
-#ifndef MAXN
-#define MAXN 40
-#endif
-#ifndef MAXVAL
-#define MAXVAL 10
-#endif
 #ifndef TRUE
 #define TRUE 1
 #endif
@@ -26,11 +20,15 @@
 
 typedef int boolean;
 
-#define MAXCODELENGTH (MAXN * MAXVAL + MAXN)
 #define EMPTY USHRT_MAX
 
-typedef unsigned short GRAPH[MAXN + 1][MAXVAL + 1];
-typedef unsigned short ADJACENCY[MAXN + 1];
+/* A graph with graph[0][0] vertices numbered from 1. The neighbours of vertex v
+ * are stored in graph[v] and adj[v] is the degree of v. Both are allocated by
+ * prepareGraph for the given vertex count and degrees, and are released by
+ * freeGraph.
+ */
+typedef unsigned short **GRAPH;
+typedef unsigned short *ADJACENCY;
 
 #ifdef	__cplusplus
 extern "C" {
@@ -40,7 +38,9 @@ void addEdge(GRAPH graph, ADJACENCY adj, int v, int w);
 
 void removeEdge(GRAPH graph, ADJACENCY adj, int v, int w, boolean all);
 
-void prepareGraph(GRAPH graph, ADJACENCY adj, int vertexCount);
+void prepareGraph(GRAPH *graph, ADJACENCY *adj, int vertexCount, int *maxDegrees);
+
+void freeGraph(GRAPH graph, ADJACENCY adj);
 
 boolean areAdjacent(GRAPH graph, ADJACENCY adj, int v, int w);
 
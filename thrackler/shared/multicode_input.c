@@ -8,24 +8,37 @@
 #include "multicode_input.h"
 #include<string.h>
 
-void decodeMultiCode(unsigned short* code, int length, GRAPH graph, ADJACENCY adj) {
-    int i, j, currentVertex;
+void decodeMultiCode(unsigned short* code, int length, GRAPH *graph, ADJACENCY *adj) {
+    int i, currentVertex;
     unsigned short vertexCount;
+    int *degrees;
 
-    graph[0][0] = vertexCount = code[0];
+    vertexCount = code[0];
 
-    //mark all vertices as having degree 0
-    for (i = 1; i <= vertexCount; i++) {
-        adj[i] = 0;
-        for (j = 0; j <= MAXVAL; j++) {
-            graph[i][j] = EMPTY;
-        }
+    //determine the degrees so each row can be allocated at its size
+    degrees = calloc(vertexCount + 1, sizeof(int));
+    if (degrees == NULL) {
+        fprintf(stderr, "Insufficient memory for graph with %d vertices -- exiting!\n", vertexCount);
+        exit(1);
     }
-    //clear first row
-    for (j = 1; j <= MAXVAL; j++) {
-        graph[0][j] = 0;
+    currentVertex = 1;
+    for (i = 1; i < length; i++) {
+        if (code[i] == 0) {
+            currentVertex++;
+        } else {
+            if (code[i] > vertexCount || currentVertex > vertexCount) {
+                fprintf(stderr, "Illegal multi_code: vertex %d does not exist -- exiting!\n",
+                        code[i] > vertexCount ? code[i] : currentVertex);
+                exit(1);
+            }
+            degrees[currentVertex]++;
+            degrees[code[i]]++;
+        }
     }
 
+    prepareGraph(graph, adj, vertexCount, degrees);
+    free(degrees);
+
     //go through code and add edges
     currentVertex = 1;
 
@@ -33,27 +46,44 @@ void decodeMultiCode(unsigned short* code, int length, GRAPH graph, ADJACENCY ad
         if (code[i] == 0) {
             currentVertex++;
         } else {
-            addEdge(graph, adj, currentVertex, (int) code[i]);
-            if ((adj[code[i]] > MAXVAL) || (adj[currentVertex] > MAXVAL)) {
-                fprintf(stderr, "MAXVAL too small (%d)!\n", MAXVAL);
-                exit(0);
-            }
+            addEdge(*graph, *adj, currentVertex, (int) code[i]);
         }
     }
 }
 
+/* Makes sure that the buffer code can hold at least size entries.
+ */
+static void ensureCodeSize(unsigned short **code, int *codeSize, int size) {
+    int newSize;
+    unsigned short *newCode;
+    
+    if (size <= *codeSize) return;
+    
+    newSize = *codeSize < 64 ? 64 : *codeSize;
+    while (newSize < size) newSize *= 2;
+    newCode = realloc(*code, sizeof (unsigned short) * newSize);
+    if (newCode == NULL) {
+        fprintf(stderr, "Insufficient memory for multi_code -- exiting!\n");
+        exit(1);
+    }
+    *code = newCode;
+    *codeSize = newSize;
+}
+
 /**
  * 
- * @param code
+ * @param code buffer for the code which is grown as needed (may point to NULL)
+ * @param codeSize the number of entries allocated in the buffer
  * @param length
  * @param file
  * @return returns 1 if a code was read and 0 otherwise. Exits in case of error.
  */
-int readMultiCode(unsigned short code[], int *length, FILE *file) {
+int readMultiCode(unsigned short **code, int *codeSize, int *length, FILE *file) {
     static int first = 1;
     unsigned char c;
     char testheader[20];
     int bufferSize, zeroCounter;
+    int nextByte;
     
     int readCount;
 
@@ -93,18 +123,20 @@ int readMultiCode(unsigned short code[], int *length, FILE *file) {
         return (0);
     }
 
+    ensureCodeSize(code, codeSize, 3);
+
     if (c == '>') {
         // could be a header, or maybe just a 62 (which is also possible for unsigned char
-        code[0] = c;
+        (*code)[0] = c;
         bufferSize = 1;
         zeroCounter = 0;
-        code[1] = (unsigned short) getc(file);
-        if (code[1] == 0) zeroCounter++;
-        code[2] = (unsigned short) getc(file);
-        if (code[2] == 0) zeroCounter++;
+        (*code)[1] = (unsigned short) getc(file);
+        if ((*code)[1] == 0) zeroCounter++;
+        (*code)[2] = (unsigned short) getc(file);
+        if ((*code)[2] == 0) zeroCounter++;
         bufferSize = 3;
         // 3 characters were read and stored in buffer
-        if ((code[1] == '>') && (code[2] == 'p')) /*we are sure that we're dealing with a header*/ {
+        if (((*code)[1] == '>') && ((*code)[2] == 'p')) /*we are sure that we're dealing with a header*/ {
             while ((c = getc(file)) != '<');
             /* read 2 more characters: */
             c = getc(file);
@@ -126,35 +158,34 @@ int readMultiCode(unsigned short code[], int *length, FILE *file) {
     }
 
     if (c != 0) /* unsigned chars would be sufficient */ {
-        code[0] = c;
-        if (code[0] > MAXN) {
-            fprintf(stderr, "Constant N too small %d > %d \n", code[0], MAXN);
-            exit(1);
-        }
-        while (zeroCounter < code[0]-1) {
-            code[bufferSize] = (unsigned short) getc(file);
-            if (code[bufferSize] == 0) zeroCounter++;
+        (*code)[0] = c;
+        while (zeroCounter < (*code)[0]-1) {
+            nextByte = getc(file);
+            if (nextByte == EOF) {
+                fprintf(stderr, "Unexpected EOF.\n");
+                exit(1);
+            }
+            ensureCodeSize(code, codeSize, bufferSize + 1);
+            (*code)[bufferSize] = (unsigned short) nextByte;
+            if ((*code)[bufferSize] == 0) zeroCounter++;
             bufferSize++;
         }
     } else {
-        readCount = fread(code, sizeof (unsigned short), 1, file);
+        readCount = fread(*code, sizeof (unsigned short), 1, file);
         if(!readCount){
             fprintf(stderr, "Unexpected EOF.\n");
             exit(1);
         }
-        if (code[0] > MAXN) {
-            fprintf(stderr, "Constant N too small %d > %d \n", code[0], MAXN);
-            exit(1);
-        }
         bufferSize = 1;
         zeroCounter = 0;
-        while (zeroCounter < code[0]-1) {
-            readCount = fread(code + bufferSize, sizeof (unsigned short), 1, file);
+        while (zeroCounter < (*code)[0]-1) {
+            ensureCodeSize(code, codeSize, bufferSize + 1);
+            readCount = fread(*code + bufferSize, sizeof (unsigned short), 1, file);
             if(!readCount){
                 fprintf(stderr, "Unexpected EOF.\n");
                 exit(1);
             }
-            if (code[bufferSize] == 0) zeroCounter++;
+            if ((*code)[bufferSize] == 0) zeroCounter++;
             bufferSize++;
         }
     }
@@ -15,9 +15,9 @@
 extern "C" {
 #endif
 
-void decodeMultiCode(unsigned short* code, int length, GRAPH graph, ADJACENCY adj);
+void decodeMultiCode(unsigned short* code, int length, GRAPH *graph, ADJACENCY *adj);
 
-int readMultiCode(unsigned short code[], int *length, FILE *file);
+int readMultiCode(unsigned short **code, int *codeSize, int *length, FILE *file);
 
 #ifdef	__cplusplus
 }
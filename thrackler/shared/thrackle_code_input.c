@@ -0,0 +1,140 @@
+/*
+ * Main developer: Nico Van Cleemput
+ * 
+ * Copyright (C) 2014 Nico Van Cleemput.
+ * Licensed under the GNU GPL, read the file LICENSE for details.
+ */
+
+#include "thrackle_code_input.h"
+#include<stdlib.h>
+#include<string.h>
+
+/* Makes sure that the buffer code can hold at least size entries.
+ */
+static void ensureCodeSize(unsigned short **code, int *codeSize, int size) {
+    int newSize;
+    unsigned short *newCode;
+    
+    if (size <= *codeSize) return;
+    
+    newSize = *codeSize < 64 ? 64 : *codeSize;
+    while (newSize < size) newSize *= 2;
+    newCode = realloc(*code, sizeof (unsigned short) * newSize);
+    if (newCode == NULL) {
+        fprintf(stderr, "Insufficient memory for thrackle_code -- exiting!\n");
+        exit(1);
+    }
+    *code = newCode;
+    *codeSize = newSize;
+}
+
+static unsigned short readEntry(FILE *file, int isShort) {
+    unsigned short entry;
+    int c;
+    
+    if (isShort) {
+        if (fread(&entry, sizeof (unsigned short), 1, file) != 1) {
+            fprintf(stderr, "Unexpected EOF.\n");
+            exit(1);
+        }
+        return entry;
+    }
+    c = getc(file);
+    if (c == EOF) {
+        fprintf(stderr, "Unexpected EOF.\n");
+        exit(1);
+    }
+    return (unsigned short) c;
+}
+
+/**
+ * 
+ * @param code buffer for the code which is grown as needed (may point to NULL)
+ * @param codeSize the number of entries allocated in the buffer
+ * @param length
+ * @param file
+ * @return returns 1 if a code was read and 0 otherwise. Exits in case of error.
+ */
+int readThrackleCode(unsigned short **code, int *codeSize, int *length, FILE *file) {
+    static int first = 1;
+    unsigned char c;
+    char testheader[20];
+    int bufferSize, zeroCounter, isShort;
+
+    if (first) {
+        first = 0;
+
+        if (fread(&testheader, sizeof (unsigned char), 15, file) != 15) {
+            fprintf(stderr, "can't read header ((1)file too small)-- exiting\n");
+            exit(1);
+        }
+        testheader[15] = 0;
+        if (strcmp(testheader, ">>thrackle_code") != 0) {
+            fprintf(stderr, "No thrackle_code header detected -- exiting!\n");
+            exit(1);
+        }
+        //read reminder of header (either empty or le/be specification)
+        do {
+            if (fread(&c, sizeof (unsigned char), 1, file) == 0) {
+                return 0;
+            }
+        } while (c != '<');
+        //read one more character
+        if (fread(&c, sizeof (unsigned char), 1, file) == 0) {
+            return 0;
+        }
+    }
+
+    ensureCodeSize(code, codeSize, 3);
+
+    /* possibly removing interior headers */
+    if (fread(&c, sizeof (unsigned char), 1, file) == 0) {
+        //nothing left in file
+        return 0;
+    }
+
+    bufferSize = 0;
+    zeroCounter = 0;
+    if (c == '>') {
+        // could be a header, or maybe just 62 vertices
+        (*code)[0] = c;
+        (*code)[1] = readEntry(file, 0);
+        (*code)[2] = readEntry(file, 0);
+        if (((*code)[1] == '>') && ((*code)[2] == 't')) /*we are sure that we're dealing with a header*/ {
+            do {
+                c = readEntry(file, 0);
+            } while (c != '<');
+            if (readEntry(file, 0) != '<') {
+                fprintf(stderr, "Problems with header -- single '<'\n");
+                exit(1);
+            }
+            if (!fread(&c, sizeof (unsigned char), 1, file)) {
+                //nothing left in file
+                return 0;
+            }
+        } else {
+            //the third entry is the first neighbour of the first vertex
+            bufferSize = 3;
+            if ((*code)[2] == 0) zeroCounter++;
+        }
+    }
+
+    if (bufferSize == 0) {
+        isShort = (c == 0);
+        (*code)[0] = isShort ? readEntry(file, 1) : c;
+        (*code)[1] = readEntry(file, isShort);
+        bufferSize = 2;
+    } else {
+        isShort = 0;
+    }
+    
+    while (zeroCounter < (*code)[0] + (*code)[1]) {
+        ensureCodeSize(code, codeSize, bufferSize + 1);
+        (*code)[bufferSize] = readEntry(file, isShort);
+        if ((*code)[bufferSize] == 0) zeroCounter++;
+        bufferSize++;
+    }
+
+    *length = bufferSize;
+    return 1;
+}
@@ -0,0 +1,31 @@
+/*
+ * Main developer: Nico Van Cleemput
+ * 
+ * Copyright (C) 2014 Nico Van Cleemput.
+ * Licensed under the GNU GPL, read the file LICENSE for details.
+ */
+
+#ifndef THRACKLE_CODE_INPUT_H
+#define	THRACKLE_CODE_INPUT_H
+
+#include<stdio.h>
+
+/* A thrackle_code starts with the number of vertices nv and the number of
+ * intersections ni. It is followed by the neighbours of each of the nv + ni
+ * vertices of the cross graph in clockwise order, numbered from 1, and each
+ * list ends with a 0. The entries are bytes, or shorts if the code starts with
+ * a 0 byte.
+ */
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+int readThrackleCode(unsigned short **code, int *codeSize, int *length, FILE *file);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* THRACKLE_CODE_INPUT_H */
+
@@ -10,7 +10,8 @@
  * 
  * Compile with:
  *     
- *     cc -o thrackler -O4 thrackler.c
+ *     cc -o thrackler -O4 thrackler.c shared/multicode_base.c shared/multicode_input.c \
+ *         shared/code_output.c shared/thrackle_code_input.c -pthread -lm
  * 
  */
 
@@ -19,6 +20,19 @@
 #include <getopt.h>
 #include <string.h>
 #include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
 
 //debug macros
 #ifdef DEBUG
@@ -33,76 +47,132 @@
 #endif
 #include "shared/multicode_base.h"
 #include "shared/multicode_input.h"
+#include "shared/code_output.h"
+#include "shared/thrackle_code_input.h"
 
-#define MAXE (MAXN*MAXVAL)/2
-#define MAXI (MAXE*(MAXE-1))/2 /* the maximum number of intersections */
-#define MAXCN MAXN + MAXI      /* the maximum number of vertices in the cross graph */
-#define MAXCE (6*MAXCN-12)     /* the maximum number of oriented edges in the cross graph */
-
-#define INFI (MAXN + 1)
+/* The search stores sets of edges in bitsets of at most MAXE bits. All other
+ * sizes follow from the input graph.
+ */
+#define MAXE 256 /* the maximum number of edges */
 
 typedef int boolean;
 
 #define FALSE 0
 #define TRUE  1
 
-typedef int VERTEXTYPE;
+/* Variables that describe the input graph and the state of a search are
+ * thread-local, so every worker thread owns a private copy of the cross graph
+ * and independent graphs can be searched at the same time.
+ */
+#define THREADLOCAL __thread
 
-#define VERTEX 0
-#define EDGEINTERSECTION 1
-#define IS_VERTEX(v) !(v)
-#define IS_INTERSECTION(v) (v)
+/* The vertices of the cross graph are the vertices of the input graph followed
+ * by the intersections, so the type of a vertex follows from its number.
+ */
+#define IS_VERTEX(v) ((v) < nv)
+#define IS_INTERSECTION(v) ((v) >= nv)
 
 typedef struct e /* The data type used for edges */ {
-    int start; /* vertex where the edge starts */
-    VERTEXTYPE startType;
-    int end; /* vertex where the edge ends */
-    VERTEXTYPE endType;
-    
-    int edgeNumber; /* the number of the edge in the original graph */
-
     struct e *prev; /* previous edge in clockwise direction */
     struct e *next; /* next edge in clockwise direction */
     struct e *inverse; /* the edge that is inverse to this one */
-    int mark, index; /* two ints for temporary use;
-                          Only access mark via the MARK macros. */
+    
+    int start; /* vertex where the edge starts */
+    int end; /* vertex where the edge ends */
+    int edgeNumber; /* the number of the edge in the original graph */
 } EDGE;
 
-EDGE *firstedge[MAXCN]; /* pointer to arbitrary edge out of vertex i. */
-int degree[MAXCN];
-
-EDGE edges[MAXCE];
+THREADLOCAL EDGE **firstedge; /* pointer to arbitrary edge out of vertex i. */
+THREADLOCAL int *degree;
 
-static int markvalue = 30000;
-#define RESETMARKS {int mki; if ((markvalue += 2) > 30000) \
-       { markvalue = 2; for (mki=0;mki<MAXCE;++mki) edges[mki].mark=0;}}
-#define MARK(e) (e)->mark = markvalue
-#define MARKLO(e) (e)->mark = markvalue
-#define MARKHI(e) (e)->mark = markvalue+1
-#define UNMARK(e) (e)->mark = markvalue-1
-#define ISMARKED(e) ((e)->mark >= markvalue)
-#define ISMARKEDLO(e) ((e)->mark == markvalue)
-#define ISMARKEDHI(e) ((e)->mark > markvalue)
+THREADLOCAL EDGE *edges;
 
-int nv; //number of vertices
-int ni; //number of intersections
+THREADLOCAL int nv; //number of vertices
+THREADLOCAL int ni; //number of intersections
 int ne; //number of (undirected) edges in the cross graph
 
-int numberedEdges[MAXE][2];
-int edgeCount;
+THREADLOCAL int numberedEdges[MAXE][2];
+THREADLOCAL int edgeCount;
+
+THREADLOCAL int intersectionCount;
+
+THREADLOCAL int edgeCounter;
+THREADLOCAL int crossGraphEdgeCounter;
+THREADLOCAL int intersectionCounter;
 
-int intersectionCount;
+THREADLOCAL unsigned long long int numberOfThrackles = 0;
 
-int edgeCounter;
-int crossGraphEdgeCounter;
-int intersectionCounter;
+/* The number of embeddings of the first k edges that were found, for each k
+ * smaller than the number of edges. A multithreaded search only counts the
+ * nodes below the root of its task, since the path to it is counted by the
+ * task that donated it.
+ */
+THREADLOCAL unsigned long long int edgeEmbeddings[MAXE];
+unsigned long long int totalEdgeEmbeddings[MAXE];
+THREADLOCAL int countFromDepth = 0;
 
-unsigned long long int numberOfThrackles = 0;
+boolean countOnly = FALSE;
 
 boolean justOne = FALSE;
 
 boolean testEdgeOrder = FALSE;
 
+//variables for the order in which the edges are added
+
+#define EDGE_ORDER_AUTO -1
+#define EDGE_ORDER_DFS 0
+#define EDGE_ORDER_BFS 1
+#define EDGE_ORDER_DEGREE 2
+#define EDGE_ORDER_CYCLES 3
+#define EDGE_ORDER_EARS 4
+#define EDGE_ORDER_COUNT 5
+
+char *edgeOrderNames[EDGE_ORDER_COUNT] = {"dfs", "bfs", "degree", "cycles", "ears"};
+int edgeOrder = EDGE_ORDER_DFS;
+
+#define EDGE_ORDER_PROBES 1000 /* the number of probes used to compare edge orders */
+
+//variables for random probes of the search tree
+
+THREADLOCAL boolean probing = FALSE;
+THREADLOCAL unsigned int probeSeed;
+THREADLOCAL double probeWeight; /* the product of the number of alternatives so far */
+THREADLOCAL double probeNodes; /* the estimated number of nodes in the search tree */
+THREADLOCAL double probeEmbeddings; /* the estimated number of embeddings */
+THREADLOCAL unsigned long long int probeSteps = 0; /* the number of nodes visited by probes */
+
+int estimateProbes = 0; /* if positive, only estimate the search with this many probes */
+
+/* For each number of embedded edges, the weight and the estimated number of
+ * nodes when the current probe reached it, or a weight of 0 if it was not
+ * reached. This is used to estimate the nodes above each split level.
+ */
+double probeLevelWeight[MAXE + 1];
+double probeLevelNodes[MAXE + 1];
+
+#define AUTO_SPLIT_PROBES 100000 /* the number of probes used for each candidate split level */
+#define AUTO_SPLIT_MAX_NODES 100000 /* the largest number of nodes at a candidate split level */
+#define AUTO_SPLIT_IMBALANCE 1.1 /* the accepted ratio of the largest part and an even share */
+
+int autoSplitParts = 0; /* if positive, select the split level for this many parts */
+/* If not NULL, this is called instead of splitting when the search reaches the
+ * split level, and the search does not continue below that node.
+ */
+void (*splitNodeHandler)() = NULL;
+int splitSampleProbes;
+int splitSampleParts;
+double *splitPartCosts;
+
+//variables for handling all graphs in the input
+boolean batchMode = FALSE;
+int graphsRead = 0;
+int graphsSkipped = 0;
+unsigned long long int batchNumberOfThrackles = 0;
+
+//variables for the census of all graphs in the input
+boolean censusMode = FALSE;
+int jobCount = 1;
+
 //variables for splitting the generation into parts
 int splitLevel = -1;
 int splitlevelCounter = 0;
@@ -113,13 +183,494 @@ int totalParts = 1;
 boolean splittingEnabled = FALSE;
 boolean testCommonPart = FALSE;
 
+//variables for tracking the position in the search tree
+
+/* Each loop over the alternatives in doNextEdge and intersectNextEdge is a
+ * choice point. The path to the current node is stored as the position of the
+ * chosen alternative at each depth. Only the positions between choiceFirst and
+ * choiceLast are explored at a given depth: this is used to replay a path and
+ * to hand the remaining alternatives of a choice point over to another thread.
+ */
+THREADLOCAL int choiceDepth = 0;
+THREADLOCAL int choiceRestricted = -1; /* no range is restricted below this depth */
+THREADLOCAL int *choicePath;
+THREADLOCAL int *choiceFirst;
+THREADLOCAL int *choiceLast;
+THREADLOCAL struct task **choiceDonated;
+
+//variables for multithreaded search
+
+int threadCount = 1;
+
+typedef struct chunk /* A piece of the output of a task */ {
+    char *data;
+    size_t size;
+    struct task *task; /* if not NULL, this chunk is the output of this task */
+
+    struct chunk *next;
+} OUTPUTCHUNK;
+
+typedef struct task /* A subtree of the search tree */ {
+    int depth; /* the number of choice points above the root of this task */
+    int *path; /* the positions of the alternatives chosen above the root */
+    int first, last; /* the alternatives at the root that belong to this task */
+
+    boolean finished;
+    OUTPUTCHUNK *firstChunk;
+    OUTPUTCHUNK *lastChunk;
+
+    struct task *parent;
+    struct task *nextInQueue;
+} SEARCHTASK;
+
+typedef struct graphstate /* The description of the graph that is searched */ {
+    int nv;
+    int edgeCount;
+    int intersectionCount;
+    int (*numberedEdges)[2];
+
+    boolean useAutomorphisms;
+    int automorphismCount;
+    int symmetryCount;
+    int *automorphisms;
+    int *edgeAutomorphisms;
+    int *comparableLevel;
+    int *symmetryStartVertex;
+    int *symmetryStartEdge;
+} GRAPHSTATE;
+
+THREADLOCAL SEARCHTASK *currentTask = NULL;
+/* Without threads the thrackle_code is written to standardOutput. Each thread
+ * collects its output in memory in outputChunk, and this is written in the
+ * order of the search by writeOrderedOutput.
+ */
+CODEOUTPUT standardOutput;
+int outputBlockSize = DEFAULT_OUTPUT_BLOCK_SIZE;
+THREADLOCAL CODEOUTPUT outputChunk;
+THREADLOCAL CODEOUTPUT *thrackleOutput;
+
+#define OUTPUT_CHUNK_SIZE (1 << 20)
+#define OUTPUT_CHUNK_START_SIZE (1 << 12)
+
+pthread_mutex_t taskMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t taskAvailable = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t outputMutex = PTHREAD_MUTEX_INITIALIZER;
+
+SEARCHTASK *taskQueueHead = NULL;
+SEARCHTASK *taskQueueTail = NULL;
+int idleThreads = 0;
+int queuedTasks = 0;
+boolean searchFinished = FALSE;
+volatile boolean workRequested = FALSE;
+volatile boolean searchStopped = FALSE;
+
+SEARCHTASK *writerTask = NULL;
+boolean orderedHeaderWritten = FALSE;
+THREADLOCAL boolean thrackleCodeHeaderWritten = FALSE;
+
+unsigned long long int totalNumberOfThrackles = 0;
+
+//variables for symmetry breaking
+
+/* The automorphisms are not used if the group has more elements than this,
+ * because the comparisons of the symmetry breaking would cost more than the
+ * pruning saves.
+ */
+#define AUTOMORPHISM_LIMIT 10000
+
+boolean breakGraphSymmetry = FALSE; /* use the automorphisms of the input graph */
+boolean breakMirrorSymmetry = FALSE; /* use the reflection of the sphere */
+boolean breakSymmetry = FALSE; /* at least one of the above */
+boolean reportLabelledCount = FALSE;
+
+THREADLOCAL boolean useAutomorphisms; /* FALSE if the group of the graph is too large */
+THREADLOCAL int automorphismCount = 1;
+/* The symmetries are the automorphisms, followed by the automorphisms combined
+ * with the reflection if mirror images are also considered.
+ */
+THREADLOCAL int symmetryCount = 1;
+THREADLOCAL int *automorphisms; /* the image of vertex v under automorphism a is at a*nv + v */
+THREADLOCAL int automorphismCapacity; /* the number of automorphisms that fit in automorphisms */
+THREADLOCAL int *edgeAutomorphisms; /* the image of edge e under automorphism a is at a*edgeCount + e */
+THREADLOCAL int *comparableLevel; /* see computeAutomorphisms */
+THREADLOCAL int *symmetryStartVertex; /* the vertex that is mapped to the first vertex of edge 0 */
+THREADLOCAL int *symmetryStartEdge; /* the edge that is mapped to edge 0 */
+
+THREADLOCAL int *symmetryState; /* the next level to compare for each symmetry */
+THREADLOCAL int stabilizerSize;
+THREADLOCAL int *symmetryCertificate;
+THREADLOCAL int symmetryCertificateLength;
+THREADLOCAL int symmetryCertificateLevel;
+THREADLOCAL int *symmetryImageCertificate;
+THREADLOCAL int *symmetryLabels;
+THREADLOCAL EDGE **symmetryEntries;
+THREADLOCAL EDGE **symmetryQueue;
+
+//variables for writing only non-isomorphic embeddings
+
+/* Each embedding is reduced to a canonical certificate of its cross graph in
+ * which the vertices of the input graph are unlabelled, as in thrackle_non_iso.
+ * The certificates of all embeddings that were written are kept in a hash set
+ * that is shared by all threads and by all graphs in a batch.
+ */
+typedef struct {
+    unsigned long long int hash;
+    int *certificate; /* NULL for an empty slot */
+} ISOMORPHISMCLASS;
+
+boolean nonIsomorphic = FALSE;
+ISOMORPHISMCLASS *isomorphismClasses = NULL;
+size_t isomorphismClassesSize = 0; /* the number of slots, a power of two */
+size_t isomorphismClassesStored = 0;
+unsigned long long int isomorphismClassCount = 0; /* new classes for the current graph */
+pthread_mutex_t isomorphismMutex = PTHREAD_MUTEX_INITIALIZER;
+
+THREADLOCAL int *canonicalCertificate;
+THREADLOCAL int *alternativeCertificate;
+THREADLOCAL int *canonicalLabels;
+THREADLOCAL EDGE **canonicalEntries;
+THREADLOCAL EDGE **canonicalQueue;
+
+//variables for deduplicating the states at the split level
+
+/* With --split-dedup the subtree below a node at the split level is only
+ * searched if the partial embedding at that node is not isomorphic to one of
+ * which the subtree was searched before. The vertices that still get edges
+ * keep their labels in such an isomorphism, so that the remaining edges have
+ * to cross the same edges in both states and both subtrees contain the same
+ * number of embeddings at each level. These numbers are stored with the
+ * certificate of each state that was searched.
+ */
+typedef struct {
+    unsigned long long int hash;
+    int *certificate; /* NULL for an empty slot */
+    unsigned long long int *counts; /* the embeddings at each level from the split level */
+} SPLITSTATE;
+
+boolean deduplicateSplitStates = FALSE;
+SPLITSTATE *splitStates = NULL;
+size_t splitStatesSize = 0; /* the number of slots, a power of two */
+size_t splitStatesStored = 0;
+unsigned long long int splitStatesSearched = 0;
+unsigned long long int splitStatesSkipped = 0;
+int deadVertexCount; /* the vertices of which all edges are before the split level */
+
+THREADLOCAL boolean *liveVertex;
+THREADLOCAL int *splitStateCertificate;
+THREADLOCAL int *alternativeSplitStateCertificate;
+THREADLOCAL int *splitStateLabels;
+THREADLOCAL EDGE **splitStateEntries;
+THREADLOCAL EDGE **splitStateQueue;
+
+//variables for the forward check in intersectNextEdge
+
+/* The faces of the cross graph are labelled and for each face the number of
+ * edges that need to be crossed to reach a face that contains the end of the
+ * current edge is stored, using only edges that still need to be crossed.
+ * When the current edge splits a face, both parts keep its label. The stored
+ * distances are therefore lower bounds in the whole subtree below the node in
+ * which they were computed.
+ * Each edge that ends in a vertex that is already embedded gets its own
+ * labels, so the labels of an edge stay valid while later edges are added.
+ */
+THREADLOCAL int *halfEdgeFace; /* the label of the face of each half-edge */
+THREADLOCAL int *faceDistance;
+THREADLOCAL int *halfEdgeFaceLevels; /* the labels for each nested edge */
+THREADLOCAL int *faceDistanceLevels;
+THREADLOCAL int faceLabelSize; /* the size of the labels of one edge */
+THREADLOCAL int faceLabelLevel = 0; /* the number of nested edges with labels */
+THREADLOCAL EDGE **faceQueue; /* a half-edge of each face that is reached */
+THREADLOCAL int *faceQueueDistance;
+THREADLOCAL int facesLabelledAt = -1; /* the depth at which the faces were labelled or -1 */
+
+//variables for the iterative search
+
+/* The iterative search keeps its choice points on an explicit stack instead
+ * of the C stack. Every change it makes to the existing part of the cross
+ * graph is recorded in a trail, and a choice point undoes the changes below
+ * it by unwinding the trail to the size it had when the choice point was
+ * created. The pointers and the integers are stored in separate trails.
+ */
+boolean iterativeSearch = FALSE;
+
+typedef struct edgetrailentry {
+    EDGE **address;
+    EDGE *value;
+} EDGETRAILENTRY;
+
+typedef struct inttrailentry {
+    int *address;
+    int value;
+} INTTRAILENTRY;
+
+THREADLOCAL EDGETRAILENTRY *edgeTrail;
+THREADLOCAL int edgeTrailSize;
+THREADLOCAL INTTRAILENTRY *intTrail;
+THREADLOCAL int intTrailSize;
+
+//variables for checkpoints
+
+/* A checkpoint is written at a choice point and contains the position of the
+ * chosen alternative at each choice point above it. All alternatives before
+ * this path have been searched, so a resumed search replays the path and
+ * continues with the alternatives on it.
+ */
+char *checkpointFileName = NULL;
+int checkpointInterval = 600; /* in seconds */
+char *resumeFileName = NULL;
+volatile boolean checkpointRequested = FALSE;
+unsigned long long int outputOffset = 0; /* the number of bytes of thrackle_code written */
+
+//variables for progress reports
+
+/* The search counts the nodes it visits for each edge. A report is written
+ * every progressInterval seconds and when SIGUSR1 is received, by the first
+ * thread that reaches a choice point. Each searching thread registers its
+ * counters, so that the report contains the totals of all threads.
+ */
+#define PROGRESS_DEPTH 8 /* the number of choice points used to estimate the progress */
+
+int progressInterval = 0; /* in seconds, or 0 if there are no periodic reports */
+char *progressFileName = NULL;
+FILE *progressOutput;
+volatile boolean progressRequested = FALSE;
+volatile int secondsElapsed;
+THREADLOCAL unsigned long long int edgeNodes[MAXE]; /* the number of nodes visited for each edge */
+THREADLOCAL int choiceSize[PROGRESS_DEPTH]; /* the number of positions at the first choice points */
+
+unsigned long long int **searcherNodes; /* edgeNodes of each searching thread */
+unsigned long long int **searcherThrackles; /* numberOfThrackles of each searching thread */
+int searcherCount = 0;
+struct timespec progressStart;
+double lastProgressSeconds;
+unsigned long long int lastProgressNodes;
+pthread_mutex_t progressMutex = PTHREAD_MUTEX_INITIALIZER;
+
+THREADLOCAL unsigned long long int labelledNumberOfThrackles = 0;
+unsigned long long int totalLabelledNumberOfThrackles = 0;
+
+//variables for the distributed search
+
+/* A coordinator searches up to the split level and hands the subtree of each
+ * node at that level as a work unit to the worker processes, which connect to
+ * it over a Unix domain socket or TCP. Each message is sent over a new
+ * connection and is answered with one line. A worker writes the embeddings of
+ * a unit to a file of its own in the unit directory, and tells the coordinator
+ * at regular times that it is still searching the unit. A unit that nothing was
+ * heard of for unitTimeout seconds is handed out again. The first result of a
+ * unit is kept, and the coordinator writes the files of all units in the order
+ * of the search.
+ */
+/* A message holds the description of the graph, the path of a unit with the
+ * name of its file, or the counts of a result.
+ */
+#define MESSAGE_SIZE (64 + GRAPH_DESCRIPTION_SIZE + 21*MAXE + 12*(edgeCount + intersectionCount) + PATH_MAX)
+#define MESSAGE_TIMEOUT 10 /* in seconds */
+#define CONNECT_ATTEMPTS 30 /* the number of seconds a worker waits for the coordinator */
+#define FINISH_GRACE_PERIOD 3 /* the number of seconds the coordinator waits after the search */
+
+#define UNIT_PENDING 0
+#define UNIT_RUNNING 1
+#define UNIT_FINISHED 2
+
+typedef struct workunit /* The subtree below a node at the split level */ {
+    int depth;
+    int *path; /* the positions chosen at the choice points above the node */
+    int state;
+    int attempt; /* the number of times the unit was handed out */
+    int acceptedAttempt; /* the attempt of which the result was kept */
+    time_t lastHeard;
+} WORKUNIT;
+
+char *coordinatorAddress = NULL;
+char *workerAddress = NULL;
+char *unitDirectory = ".";
+int unitTimeout = 60; /* in seconds */
+
+WORKUNIT *workUnits = NULL;
+int workUnitCount = 0;
+int workUnitCapacity = 0;
+int nextWorkUnit; /* the first unit that was never handed out */
+int reassignedWorkUnits; /* the number of units that wait to be handed out again */
+int finishedWorkUnits;
+
+char *messageBuffer; /* both have MESSAGE_SIZE bytes */
+char *replyBuffer;
+
+int currentUnit; /* the unit and the attempt this worker is searching */
+int currentAttempt;
+int heartbeatInterval; /* in seconds */
+volatile boolean heartbeatRequested = FALSE;
+boolean unitCancelled = FALSE;
+
+//variables for extending the embeddings of a subgraph
+
+/* With --extend the embeddings of a subgraph of the input graph are read and
+ * the search only adds the other edges to each of them. The edges of the
+ * subgraph are numbered first, and its vertices are the first vertices of the
+ * input graph. The intersections of an embedding keep their order, but are
+ * numbered after all vertices of the input graph.
+ */
+char *extendFileName = NULL;
+FILE *extendFile;
+unsigned short *extendCode = NULL; /* the embedding that is extended next */
+int extendCodeSize = 0;
+int extendCodeLength;
+int *extendRotation = NULL; /* the position in extendCode of the neighbours of each vertex */
+int *extendDegree = NULL;
+int *extendFirstHalfEdge = NULL; /* the half-edge in edges of the first neighbour of each vertex */
+int extendedVertexCount;
+int extendedEdgeCount = 0;
+int extendedIntersectionCount;
+unsigned long long int extendedThrackles = 0; /* the number of embeddings that were extended */
+
+//variables for rejecting graphs that contain a forbidden subgraph
+
+/* Every subgraph of a graph with a thrackle embedding has a thrackle embedding
+ * as well, so a graph that contains a graph without thrackle embedding can be
+ * rejected without a search. Apart from C4 these are the connected graphs
+ * with at most 6 vertices that contain no C4 and have no thrackle embedding,
+ * as found by this program. The vertices of a forbidden subgraph are numbered
+ * such that each vertex after the first is adjacent to an earlier one.
+ */
+#define FORBIDDEN_MAX_EDGES 8
+
+typedef struct {
+    char *name;
+    int order;
+    int size;
+    int edges[FORBIDDEN_MAX_EDGES][2];
+} FORBIDDENSUBGRAPH;
+
+FORBIDDENSUBGRAPH forbiddenSubgraphs[] = {
+    {"C4", 4, 4, {{0, 1}, {1, 2}, {2, 3}, {3, 0}}},
+    {"bowtie", 5, 6, {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {3, 4}, {4, 0}}},
+    {"dumbbell", 6, 7, {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {3, 4}, {4, 5}, {5, 3}}},
+    {"theta(1,2,4)", 6, 7, {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {3, 4}, {4, 5}, {5, 1}}}
+};
+#define FORBIDDEN_SUBGRAPH_COUNT ((int) (sizeof(forbiddenSubgraphs) / sizeof(FORBIDDENSUBGRAPH)))
+#define FORBIDDEN_MAX_ORDER 6
+
+boolean rejectForbiddenSubgraphs = FALSE;
+unsigned long long int forbiddenSubgraphRejections = 0;
+
+//variables for the results store
+
+/* With --results the result of each search is kept in a file, so that a graph
+ * that was searched before is not searched again. The graphs are identified by
+ * a key that consists of the order, the size and the edges of a canonical
+ * labelling, which is found by refining a colouring of the vertices and
+ * individualizing the vertices of a cell in turn, so isomorphic graphs have the
+ * same key. Every subgraph of a thrackleable graph is thrackleable and every
+ * graph that contains a graph without thrackle embedding has none either, so
+ * the stored graphs also decide their subgraphs and supergraphs.
+ */
+#define CANONICAL_MAX_LEAVES 100000 /* the labelling is given up after this many leaves */
+
+typedef struct storedresult /* A graph in the results store and its result */ {
+    int *key;
+    unsigned long long int hash;
+    int order;
+    int size;
+    GRAPH graph; /* the graph with the canonical labelling */
+    ADJACENCY adj;
+    int (*edges)[2]; /* the edges with the vertices in breadth-first order */
+    int *breadthFirstLabel; /* the breadth-first number of each canonical vertex */
+    int *degrees; /* the degrees in decreasing order */
+    long long int count; /* the number of thrackle embeddings, or -1 if unknown */
+    boolean thrackleable;
+    int edgeOrder; /* the edge order of the search, or -1 if unknown */
+    double seconds;
+} STOREDRESULT;
+
+#define RESULT_NOT_STORED 0
+#define RESULT_STORED 1 /* the graph itself is stored */
+#define RESULT_STORED_SUBGRAPH 2 /* it contains a stored graph without embedding */
+#define RESULT_STORED_SUPERGRAPH 3 /* it is a subgraph of a stored thrackleable graph */
+
+typedef struct resultlookup /* What the results store knows about a graph */ {
+    int kind;
+    int entry; /* the number of the stored graph that decides the result */
+    int order; /* the order of that graph */
+    long long int count;
+    boolean thrackleable;
+    int edgeOrder;
+    double seconds;
+    int *witness; /* the vertices to which the vertices of a stored subgraph are mapped */
+} RESULTLOOKUP;
+
+char *resultsFileName = NULL;
+FILE *resultsFile;
+STOREDRESULT *storedResults = NULL;
+int storedResultCount = 0;
+int storedResultCapacity = 0;
+int *storedResultSlots = NULL; /* open addressing on the hashes of the keys, -1 if free */
+size_t storedResultSlotCount = 0;
+unsigned long long int servedResults = 0;
+
+pthread_mutex_t resultsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+THREADLOCAL int *graphKey = NULL; /* the key of the graph that is searched, or NULL */
+THREADLOCAL int usedEdgeOrder; /* the edge order of the last call to orderEdges */
+THREADLOCAL GRAPH keyGraph; /* the graph that is being labelled */
+THREADLOCAL ADJACENCY keyAdj;
+THREADLOCAL int *keyColour; /* the colouring that is compared by compareKeyVertices */
+THREADLOCAL int *keyNeighbourColours; /* the sorted colours of the neighbours of each vertex */
+THREADLOCAL int keyRowSize;
+THREADLOCAL int *keyCertificate; /* the smallest certificate of a leaf so far */
+THREADLOCAL int *keyLeafCertificate;
+THREADLOCAL int keyLeaves;
+
+//variables for the census
+
+typedef struct censusentry /* A graph of the input and the result of its search */ {
+    int number;
+    unsigned short *code;
+    int codeSize; /* the number of entries allocated for the code */
+    int length;
+
+    boolean done;
+    boolean skipped;
+    int forbidden; /* the forbidden subgraph that was found, or -1 */
+    int witness[FORBIDDEN_MAX_ORDER];
+    boolean served; /* the result was taken from the results store */
+    RESULTLOOKUP stored;
+    int *storedWitness;
+    int storedWitnessSize;
+    int order;
+    int size;
+    unsigned long long int count;
+    unsigned long long int labelledCount;
+    double seconds;
+} CENSUSENTRY;
+
+/* The graphs that are being searched are stored in a circular buffer. The
+ * results are written in the order of the input, so a graph can only be read
+ * when the result of the graph that occupied its slot has been written.
+ */
+CENSUSENTRY *censusBuffer;
+int censusBufferSize;
+int censusRead = 0; /* the number of graphs that were read */
+int censusTaken = 0; /* the number of graphs that were handed to a worker */
+int censusWritten = 0; /* the number of results that were written */
+int censusThrackleable = 0;
+boolean censusInputFinished = FALSE;
+
+pthread_mutex_t censusMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t censusGraphAvailable = PTHREAD_COND_INITIALIZER;
+pthread_cond_t censusSlotAvailable = PTHREAD_COND_INITIALIZER;
+
 //bit vectors
 
-typedef unsigned long long int bitset;
+/* The type bitset is defined separately for each instantiation of the search,
+ * so that the search for small graphs uses a single machine word.
+ */
+
+#define MAXBITSETWIDTH MAXE
 
-#define ZERO 0ULL
-#define ONE 1ULL
-#define EMPTY_SET 0ULL
+#define ZERO ((bitset)0)
+#define ONE ((bitset)1)
+#define EMPTY_SET ((bitset)0)
 #define SINGLETON(el) (ONE << (el))
 #define IS_SINGLETON(s) ((s) && (!((s) & ((s)-1))))
 #define HAS_MORE_THAN_ONE_ELEMENT(s) ((s) & ((s)-1))
@@ -142,12 +693,44 @@ typedef unsigned long long int bitset;
 #define ALL_UP_TO(el) (SINGLETON((el)+1)-1)
 #define TOGGLE(s, el) ((s) ^= SINGLETON(el))
 #define TOGGLE_ALL(s, elements) ((s) ^= (elements))
+#define SIZE(s) __builtin_popcountll(s)
+
+typedef struct {
+    unsigned long long int word[MAXBITSETWIDTH/64];
+} bitset256;
+
+bitset256 minus256(bitset256 s, int el){
+    s.word[el >> 6] ^= 1ULL << (el & 63);
+    return s;
+}
+
+bitset256 allUpTo256(int el){
+    bitset256 s;
+    int i;
+    
+    for(i = 0; i < MAXBITSETWIDTH/64; i++){
+        if(el >= 64*i + 63){
+            s.word[i] = ~0ULL;
+        } else if(el >= 64*i){
+            s.word[i] = (1ULL << (el - 64*i + 1)) - 1;
+        } else {
+            s.word[i] = 0ULL;
+        }
+    }
+    return s;
+}
 
 //////////////////////////////////////////////////////////////////////////////
 
 void writeThrackleCode();
-void doNextEdge();
 void printEndSummary();
+void donateWork();
+void writeCheckpoint(boolean finished);
+void printProgress();
+void finishChoice(int depth);
+void sendHeartbeat();
+void stopSearch();
+void rotateOutputChunk();
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -190,306 +773,920 @@ void printEdgeNumbering(){
 
 //////////////////////////////////////////////////////////////////////////////
 
-void handleThrackle(){
-    if(testCommonPart){
+//the search that is used for the current graph
+THREADLOCAL void (*doNextEdge)() = NULL;
+
+//=============== Symmetry breaking ===========================
+
+/* An automorphism of the input graph maps a thrackle embedding to another
+ * thrackle embedding by relabelling the vertices, and the reflection maps a
+ * thrackle embedding to its mirror image by reversing all rotations. When
+ * symmetry breaking is enabled, only the embedding with the smallest
+ * certificate in each orbit is accepted. The certificate of an embedding is
+ * the concatenation of the certificates of its restrictions to the edges 0 up
+ * to j-1 for increasing j. The certificate of the image of the current partial
+ * thrackle under a symmetry can be compared up to level j as soon as the edges
+ * that are mapped to the edges 0 up to j-1 have all been embedded, so branches
+ * that can only lead to embeddings that are not the smallest in their orbit
+ * are pruned in doNextEdge. For the reflection this already happens for the
+ * first edge that makes the thrackle differ from its mirror image, which is
+ * usually the third edge.
+ */
+
+boolean isAdjacent(GRAPH graph, ADJACENCY adj, int v, int w){
+    int i;
+    
+    for(i = 0; i < adj[v]; i++){
+        if(graph[v][i] == w){
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void storeAutomorphism(int *image){
+    int i;
+    
+    if(automorphismCount == AUTOMORPHISM_LIMIT){
+        automorphismCount++;
+        return;
+    } else if(automorphismCount > AUTOMORPHISM_LIMIT){
         return;
     }
-    numberOfThrackles++;
-    ni = intersectionCounter;
-    writeThrackleCode();
-    if(justOne){
-        printEndSummary();
-        exit(EXIT_SUCCESS);
+    
+    if(automorphismCount == automorphismCapacity){
+        automorphismCapacity *= 2;
+        automorphisms = realloc(automorphisms, sizeof(int) * nv * automorphismCapacity);
+        if(automorphisms == NULL){
+            fprintf(stderr, "Insufficient memory for automorphisms -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
     }
+    for(i = 0; i < nv; i++){
+        automorphisms[automorphismCount*nv + i] = image[i];
+    }
+    automorphismCount++;
 }
 
-void intersectNextEdge(EDGE *neighbouringEdge,
-        bitset nonIntersectedEdges, int currentEdge, int targetVertex){
-    if(IS_NOT_EMPTY(nonIntersectedEdges)){
-        //we still need to intersect some edges
-        
-        EDGE *e, *elast;
-        e = elast = neighbouringEdge;
-        do {
-            if(CONTAINS(nonIntersectedEdges, e->edgeNumber)){
-                DEBUGPRINT("Current edge: %d -- intersecting %d\n", currentEdge + 1, e->edgeNumber + 1);
-                //we still need to intersect this edge, so let us try it
-                EDGE *neighbouringEdgeNext = neighbouringEdge->next;
-                EDGE *eInverse = e->inverse;
-                //the new edges crossing the face
-                EDGE *newCrossingEdge = edges + crossGraphEdgeCounter++;
-                EDGE *newCrossingEdgeInverse = edges + crossGraphEdgeCounter++;
-                //the other new edges created by the intersection
-                EDGE *newEdgeAtE = edges + crossGraphEdgeCounter++;
-                EDGE *newEdgeAtEInverse = edges + crossGraphEdgeCounter++;
-                
-                int newVertex = nv + intersectionCounter++;
-                
-                newCrossingEdge->start = neighbouringEdge->start;
-                newCrossingEdge->startType = neighbouringEdge->startType;
-                newCrossingEdge->end = newVertex;
-                newCrossingEdge->endType = EDGEINTERSECTION;
-                newCrossingEdge->edgeNumber = currentEdge;
-                newCrossingEdge->inverse = newCrossingEdgeInverse;
-                newCrossingEdge->prev = neighbouringEdge;
-                newCrossingEdge->next = neighbouringEdgeNext;
-                
-                newCrossingEdgeInverse->start = newVertex;
-                newCrossingEdgeInverse->startType = EDGEINTERSECTION;
-                newCrossingEdgeInverse->end = neighbouringEdge->start;
-                newCrossingEdgeInverse->endType = neighbouringEdge->startType;
-                newCrossingEdgeInverse->edgeNumber = currentEdge;
-                newCrossingEdgeInverse->inverse = newCrossingEdge;
-                newCrossingEdgeInverse->prev = newEdgeAtEInverse;
-                newCrossingEdgeInverse->next = newEdgeAtE;
-                
-                newEdgeAtE->start = newVertex;
-                newEdgeAtE->startType = EDGEINTERSECTION;
-                newEdgeAtE->end = e->start;
-                newEdgeAtE->endType = e->startType;
-                newEdgeAtE->edgeNumber = e->edgeNumber;
-                newEdgeAtE->inverse = e;
-                newEdgeAtE->prev = newCrossingEdgeInverse;
-                newEdgeAtE->next = newEdgeAtEInverse;
-                
-                newEdgeAtEInverse->start = newVertex;
-                newEdgeAtEInverse->startType = EDGEINTERSECTION;
-                newEdgeAtEInverse->end = eInverse->start;
-                newEdgeAtEInverse->endType = eInverse->startType;
-                newEdgeAtEInverse->edgeNumber = eInverse->edgeNumber;
-                newEdgeAtEInverse->inverse = eInverse;
-                newEdgeAtEInverse->prev = newEdgeAtE;
-                newEdgeAtEInverse->next = newCrossingEdgeInverse;
-                
-                e->inverse = newEdgeAtE;
-                eInverse->inverse = newEdgeAtEInverse;
-                neighbouringEdge->next = newCrossingEdge;
-                neighbouringEdgeNext->prev = newCrossingEdge;
-                e->end = newVertex;
-                e->endType = EDGEINTERSECTION;
-                eInverse->end = newVertex;
-                eInverse->endType = EDGEINTERSECTION;
-                
-                firstedge[newVertex] = newCrossingEdgeInverse;
-                degree[newVertex] = 3;
-                degree[neighbouringEdge->start]++;
-                DEBUGCALL(printThrackle());
-                
-                //go to next intersection
-                intersectNextEdge(newEdgeAtE, MINUS(nonIntersectedEdges, e->edgeNumber),
-                        currentEdge, targetVertex);
-                
-                //backtracking
-                DEBUGPRINT("Backtracking with edge %d\n", currentEdge + 1);
-                intersectionCounter--;
-                crossGraphEdgeCounter-=4;
-                degree[neighbouringEdge->start]--;
-                e->inverse = eInverse;
-                eInverse->inverse = e;
-                neighbouringEdge->next = neighbouringEdgeNext;
-                neighbouringEdgeNext->prev = neighbouringEdge;
-                e->end = eInverse->start;
-                e->endType = eInverse->startType;
-                eInverse->end = e->start;
-                eInverse->endType = e->startType;
-            }
-            e = e->inverse->prev;
-        } while (e != elast);
-    } else {
-        //we have intersected all edges: check that target vertex is in the current face
-        
-        if(degree[targetVertex]==0){
-            //vertex is not yet in the graph
-            EDGE* newEdge = edges + crossGraphEdgeCounter++;
-            EDGE* newEdgeInverse = edges + crossGraphEdgeCounter++;
-            
-            int startVertex = neighbouringEdge->start;
-            VERTEXTYPE startVertexType = neighbouringEdge->startType;
-            
-            newEdge->start = startVertex;
-            newEdge->startType = startVertexType;
-            newEdge->end = targetVertex;
-            newEdge->endType = VERTEX;
-            newEdge->edgeNumber = currentEdge;
-            
-            EDGE *nextEdge = neighbouringEdge->next;
-            neighbouringEdge->next = newEdge;
-            newEdge->prev = neighbouringEdge;
-            nextEdge->prev = newEdge;
-            newEdge->next = nextEdge;
-
-            newEdgeInverse->start = targetVertex;
-            newEdgeInverse->startType = VERTEX;
-            newEdgeInverse->end = startVertex;
-            newEdgeInverse->endType = startVertexType;
-            newEdgeInverse->next = newEdgeInverse->prev = newEdgeInverse;
-            newEdgeInverse->edgeNumber = currentEdge;
-
-            newEdge->inverse = newEdgeInverse;
-            newEdgeInverse->inverse = newEdge;
-            
-            degree[startVertex]++;
-            degree[targetVertex] = 1;
-            firstedge[targetVertex] = newEdgeInverse;
-            
-            //go to next edge
-            doNextEdge();
-            
-            //backtracking
-            degree[startVertex]--;
-            degree[targetVertex] = 0;
-            crossGraphEdgeCounter -= 2;
-            nextEdge->prev = neighbouringEdge;
-            neighbouringEdge->next = nextEdge;
-        } else {
-            EDGE *e, *elast;
-            e = elast = neighbouringEdge;
-            do {
-                if(e->end == targetVertex){
-                    break;
-                }
-                e = e->inverse->prev;
-            } while (e != elast);
-
-            if(e->end != targetVertex){
+/* Extends the partial automorphism that maps the first position vertices of
+ * vertexOrder.
+ */
+void extendAutomorphism(GRAPH graph, ADJACENCY adj, int *vertexOrder, int position,
+        int *image, boolean *isImage){
+    int i, j, v, w;
+    
+    if(position == nv){
+        for(i = 0; i < nv; i++){
+            if(image[i] != i){
+                //the identity is always stored first
+                storeAutomorphism(image);
                 return;
             }
-
-            //make connection with target vertex
-            EDGE* newEdge = edges + crossGraphEdgeCounter++;
-            EDGE* newEdgeInverse = edges + crossGraphEdgeCounter++;
-            
-            int startVertex = neighbouringEdge->start;
-            VERTEXTYPE startVertexType = neighbouringEdge->startType;
-            
-            newEdge->start = startVertex;
-            newEdge->startType = startVertexType;
-            newEdge->end = targetVertex;
-            newEdge->endType = VERTEX;
-            newEdge->edgeNumber = currentEdge;
-            
-            EDGE *nextEdge = neighbouringEdge->next;
-            neighbouringEdge->next = newEdge;
-            newEdge->prev = neighbouringEdge;
-            nextEdge->prev = newEdge;
-            newEdge->next = nextEdge;
-
-            newEdgeInverse->start = targetVertex;
-            newEdgeInverse->startType = VERTEX;
-            newEdgeInverse->end = startVertex;
-            newEdgeInverse->endType = startVertexType;
-            newEdgeInverse->edgeNumber = currentEdge;
-            
-            EDGE *nextEdgeInverse = e->inverse;
-            EDGE *prevEdgeInverse = nextEdgeInverse->prev;
-            nextEdgeInverse->prev = newEdgeInverse;
-            newEdgeInverse->next = nextEdgeInverse;
-            prevEdgeInverse->next = newEdgeInverse;
-            newEdgeInverse->prev = prevEdgeInverse;
-
-            newEdge->inverse = newEdgeInverse;
-            newEdgeInverse->inverse = newEdge;
-            
-            degree[startVertex]++;
-            degree[targetVertex]++;
-            
-            //go to next edge
-            doNextEdge();
-            
-            //backtrack
-            degree[startVertex]--;
-            degree[targetVertex]--;
-            crossGraphEdgeCounter -= 2;
-            nextEdge->prev = neighbouringEdge;
-            neighbouringEdge->next = nextEdge;
-            nextEdgeInverse->prev = prevEdgeInverse;
-            prevEdgeInverse->next = nextEdgeInverse;
-        }
-    }
-}
-
-void doNextEdge(){
-    if(edgeCounter == edgeCount){
-        //all edges are embedded
-        handleThrackle();
+        }
+        return;
+    }
+    if(automorphismCount > AUTOMORPHISM_LIMIT){
         return;
     }
     
-    if(edgeCounter == splitLevel){
-        int inPart = splitlevelCounter%totalParts;
-        splitlevelCounter++;
-        if(testCommonPart || (inPart != currentPart)){
-            return;
+    v = vertexOrder[position];
+    for(w = 0; w < nv; w++){
+        if(isImage[w] || adj[w+1] != adj[v+1]){
+            continue;
+        }
+        for(j = 0; j < position; j++){
+            int u = vertexOrder[j];
+            if(isAdjacent(graph, adj, v+1, u+1) != isAdjacent(graph, adj, w+1, image[u]+1)){
+                break;
+            }
         }
+        if(j == position){
+            image[v] = w;
+            isImage[w] = TRUE;
+            extendAutomorphism(graph, adj, vertexOrder, position + 1, image, isImage);
+            isImage[w] = FALSE;
+        }
+    }
+}
+
+/* Computes the automorphism group of the input graph and the action of each
+ * automorphism on the numbered edges. Only the identity is used if the
+ * automorphisms are not used for symmetry breaking or if the group is too
+ * large.
+ */
+void computeAutomorphisms(GRAPH graph, ADJACENCY adj){
+    int i, j, k, a;
+    int vertexOrder[nv], image[nv];
+    boolean isImage[nv];
+    int edgeNumber[nv][nv];
+    
+    //the array grows as automorphisms are found
+    automorphismCapacity = 16;
+    automorphisms = malloc(sizeof(int) * nv * automorphismCapacity);
+    if(automorphisms == NULL){
+        fprintf(stderr, "Insufficient memory for automorphisms -- exiting!\n");
+        exit(EXIT_FAILURE);
     }
     
-    int from, to;
+    //the identity
+    for(i = 0; i < nv; i++){
+        image[i] = i;
+        isImage[i] = FALSE;
+    }
+    automorphismCount = 0;
+    storeAutomorphism(image);
     
-    int currentEdge = edgeCounter++;
+    //map the vertices in the order in which they are reached by the edges
+    vertexOrder[0] = numberedEdges[0][0];
+    k = 1;
+    for(i = 0; i < edgeCount; i++){
+        for(j = 0; j < 2; j++){
+            int v = numberedEdges[i][j];
+            int l;
+            for(l = 0; l < k && vertexOrder[l] != v; l++);
+            if(l == k){
+                vertexOrder[k++] = v;
+            }
+        }
+    }
     
-    from = numberedEdges[currentEdge][0];
-    to = numberedEdges[currentEdge][1];
+    useAutomorphisms = breakGraphSymmetry;
+    if(useAutomorphisms){
+        extendAutomorphism(graph, adj, vertexOrder, 0, image, isImage);
+    }
     
-    //weave edge through current thrackle
-    EDGE *e, *elast, newEdge;
+    if(automorphismCount > AUTOMORPHISM_LIMIT){
+        fprintf(stderr, "Automorphism group has more than %d elements: automorphisms are not used.\n",
+                AUTOMORPHISM_LIMIT);
+        useAutomorphisms = FALSE;
+        automorphismCount = 1;
+    }
+    symmetryCount = breakMirrorSymmetry ? 2*automorphismCount : automorphismCount;
     
-    bitset nonIntersectedEdges = ALL_UP_TO(currentEdge-1);
+    //action on the edges
+    for(i = 0; i < edgeCount; i++){
+        edgeNumber[numberedEdges[i][0]][numberedEdges[i][1]] = 
+                edgeNumber[numberedEdges[i][1]][numberedEdges[i][0]] = i;
+    }
+    edgeAutomorphisms = malloc(sizeof(int) * edgeCount * automorphismCount);
+    comparableLevel = malloc(sizeof(int) * (edgeCount + 1) * automorphismCount);
+    symmetryStartVertex = malloc(sizeof(int) * automorphismCount);
+    symmetryStartEdge = malloc(sizeof(int) * automorphismCount);
+    if(edgeAutomorphisms == NULL || comparableLevel == NULL ||
+            symmetryStartVertex == NULL || symmetryStartEdge == NULL){
+        fprintf(stderr, "Insufficient memory for automorphisms -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(a = 0; a < automorphismCount; a++){
+        int *sigma = automorphisms + a*nv;
+        int *sigmaEdge = edgeAutomorphisms + a*edgeCount;
+        int *level = comparableLevel + a*(edgeCount + 1);
+        for(i = 0; i < edgeCount; i++){
+            sigmaEdge[i] = edgeNumber[sigma[numberedEdges[i][0]]][sigma[numberedEdges[i][1]]];
+            if(sigmaEdge[i] == 0){
+                symmetryStartEdge[a] = i;
+            }
+        }
+        for(i = 0; i < nv; i++){
+            if(sigma[i] == numberedEdges[0][0]){
+                symmetryStartVertex[a] = i;
+            }
+        }
+        //the images of the edges 0 up to j-1 are embedded as soon as edge
+        //k-1 is embedded for all j not larger than level[k]
+        level[edgeCount] = edgeCount;
+        for(k = edgeCount - 1; k >= 0; k--){
+            level[k] = level[k+1] < sigmaEdge[k] ? level[k+1] : sigmaEdge[k];
+        }
+    }
+}
+
+void freeAutomorphisms(){
+    free(automorphisms);
+    free(edgeAutomorphisms);
+    free(comparableLevel);
+    free(symmetryStartVertex);
+    free(symmetryStartEdge);
+}
+
+/* Returns the half-edge through which the edge of e arrives in a vertex of the
+ * subgraph of the current thrackle that consists of the edges that are mapped
+ * to the edges 0 up to level-1. Intersections with other edges are skipped.
+ */
+EDGE *restrictedArrival(EDGE *e, int *sigmaEdge, int level){
+    while(IS_INTERSECTION(e->end)){
+        EDGE *back = e->inverse;
+        if(sigmaEdge[back->next->edgeNumber] < level){
+            return back;
+        }
+        //continue straight on
+        e = back->next->next;
+    }
+    return e->inverse;
+}
+
+/* Stores the certificate of the image under symmetry s of the current
+ * thrackle restricted to the edges that are mapped to the edges 0 up to
+ * level-1. The vertices keep their label under the automorphism and the
+ * intersections are numbered in the order in which they are reached by a
+ * breadth-first search.
+ */
+void getRestrictedCertificate(int s, int level, int *certificate, int *length){
+    int a = s % automorphismCount;
+    boolean mirror = s >= automorphismCount;
+    int *sigma = automorphisms + a*nv;
+    int *sigmaEdge = edgeAutomorphisms + a*edgeCount;
+    int i, pos, head, tail, labelCounter;
+    EDGE *e, *elast, *start;
     
-    DEBUGPRINT("Next edge: %d (%d - %d)\n", currentEdge+1, from + 1, to + 1);
+    for(i = 0; i < nv + intersectionCounter; i++){
+        symmetryLabels[i] = -1;
+    }
+    for(i = 0; i < nv; i++){
+        symmetryEntries[i] = NULL;
+    }
     
-    //the vertex from will always have a degree different from 0
-    e = elast = firstedge[from];
-    do {
-        REMOVE(nonIntersectedEdges, e->edgeNumber);
-        DEBUGPRINT("Removing %d from non-intersected edges\n", e->edgeNumber + 1);
+    e = elast = firstedge[symmetryStartVertex[a]];
+    while(e->edgeNumber != symmetryStartEdge[a]){
         e = e->next;
-    } while (e != elast);
-    if(degree[to]>0){
-        e = elast = firstedge[to];
-        do {
-            REMOVE(nonIntersectedEdges, e->edgeNumber);
-            DEBUGPRINT("Removing %d from non-intersected edges\n", e->edgeNumber + 1);
-            e = e->next;
-        } while (e != elast);
     }
+    start = e;
+    symmetryLabels[start->start] = sigma[start->start];
+    symmetryEntries[sigma[start->start]] = start;
+    labelCounter = nv;
+    head = tail = 0;
+    symmetryQueue[head++] = start;
     
-    //add the first part of edge
-    e = elast = firstedge[from];
-    do {
-        intersectNextEdge(e, nonIntersectedEdges, currentEdge, to);
-        e = e->next;
-    } while (e != elast);
+    while(tail < head){
+        EDGE *entry = symmetryQueue[tail++];
+        e = entry;
+        do {
+            if(sigmaEdge[e->edgeNumber] < level){
+                EDGE *arrival = restrictedArrival(e, sigmaEdge, level);
+                int v = arrival->start;
+                if(symmetryLabels[v] == -1){
+                    int label = v < nv ? sigma[v] : labelCounter++;
+                    symmetryLabels[v] = label;
+                    symmetryEntries[label] = arrival;
+                    symmetryQueue[head++] = arrival;
+                }
+            }
+            e = mirror ? e->prev : e->next;
+        } while (e != entry);
+    }
     
-    edgeCounter--;
+    pos = 0;
+    for(i = 0; i < labelCounter; i++){
+        if(symmetryEntries[i] != NULL){
+            e = elast = symmetryEntries[i];
+            do {
+                if(sigmaEdge[e->edgeNumber] < level){
+                    certificate[pos++] = 
+                            symmetryLabels[restrictedArrival(e, sigmaEdge, level)->start];
+                }
+                e = mirror ? e->prev : e->next;
+            } while (e != elast);
+        }
+        certificate[pos++] = -1;
+    }
+    *length = pos;
 }
 
-void startThrackling(){
-    int i, from, to;
-    
-    intersectionCounter = 0;
-    crossGraphEdgeCounter = 0;
-    edgeCounter = 0;
+/* Returns -1, 0 or 1 depending on whether the certificate of the image under
+ * symmetry s of the current thrackle restricted to the edges 0 up to level-1
+ * is smaller than, equal to or larger than that of the current thrackle.
+ */
+int compareRestrictedCertificates(int s, int level){
+    int i, imageLength;
     
-    for(i = 0; i < nv + intersectionCount; i++){
-        firstedge[i] = NULL;
-        degree[i] = 0;
+    //the certificate of the current thrackle is reused for the same level
+    if(symmetryCertificateLevel != level){
+        getRestrictedCertificate(0, level, symmetryCertificate, &symmetryCertificateLength);
+        symmetryCertificateLevel = level;
     }
+    getRestrictedCertificate(s, level, symmetryImageCertificate, &imageLength);
     
-    //first edge
-    from = numberedEdges[edgeCounter][0];
-    to = numberedEdges[edgeCounter][1];
+    for(i = 0; i < symmetryCertificateLength; i++){
+        if(symmetryImageCertificate[i] < symmetryCertificate[i]){
+            return -1;
+        } else if(symmetryImageCertificate[i] > symmetryCertificate[i]){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Returns TRUE if the current thrackle on the edges 0 up to edgeCounter-1 can
+ * still be extended to an embedding that is the smallest in its orbit. For a
+ * complete embedding, the size of its stabilizer is stored in stabilizerSize.
+ */
+boolean isSmallestInOrbitSoFar(){
+    int s, next;
+    int *previous = symmetryState + (edgeCounter - 1)*symmetryCount;
+    int *current = symmetryState + edgeCounter*symmetryCount;
     
-    EDGE *firstEdge = edges + crossGraphEdgeCounter++;
-    firstEdge->edgeNumber = edgeCounter;
-    firstEdge->start = from;
-    firstEdge->end = to;
-    firstEdge->startType = firstEdge->endType = VERTEX;
-    firstEdge->next = firstEdge->prev = firstEdge;
-    EDGE *inverseFirstEdge = edges + crossGraphEdgeCounter++;
-    inverseFirstEdge->edgeNumber = edgeCounter;
+    stabilizerSize = 1;
+    symmetryCertificateLevel = -1;
+    for(s = 1; s < symmetryCount; s++){
+        //for the first edge counter the previous state is not yet initialised
+        next = edgeCounter == 2 ? 3 : previous[s];
+        if(next >= 0){
+            int a = s % automorphismCount;
+            int comparable = comparableLevel[a*(edgeCount + 1) + edgeCounter];
+            while(next <= comparable){
+                int comparison = compareRestrictedCertificates(s, next);
+                if(comparison < 0){
+                    return FALSE;
+                } else if(comparison > 0){
+                    next = -1;
+                    break;
+                }
+                next++;
+            }
+            if(next > edgeCount){
+                stabilizerSize++;
+            }
+        }
+        current[s] = next;
+    }
+    return TRUE;
+}
+
+//=============== Isomorphism classes ===========================
+
+/* Stores the certificate of the current thrackle that is obtained by a
+ * breadth-first search starting from the half-edge start. The vertices of the
+ * input graph and the intersections are numbered separately in the order in
+ * which they are reached, and with mirror the rotations are reversed. The
+ * certificate consists of nv and ni followed by the neighbours of each vertex
+ * in the order of the new labels, each terminated by -1.
+ * 
+ * If best is not NULL, the construction stops as soon as the certificate is
+ * known not to be smaller than best. Returns TRUE if a certificate was stored
+ * that is smaller than best.
+ */
+boolean getCanonicalCandidate(EDGE *start, boolean mirror, int *certificate, int *best){
+    int i, pos, head, tail, vertexLabel, intersectionLabel;
+    boolean smaller = best == NULL;
+    EDGE *e, *elast;
+    
+    for(i = 0; i < nv + ni; i++){
+        canonicalLabels[i] = -1;
+    }
+    
+    canonicalLabels[start->start] = 0;
+    canonicalEntries[0] = start;
+    vertexLabel = 1;
+    intersectionLabel = nv;
+    head = tail = 0;
+    canonicalQueue[head++] = start;
+    
+    while(tail < head){
+        EDGE *entry = canonicalQueue[tail++];
+        e = entry;
+        do {
+            if(canonicalLabels[e->end] == -1){
+                int label = e->end < nv ? vertexLabel++ : intersectionLabel++;
+                canonicalLabels[e->end] = label;
+                canonicalEntries[label] = e->inverse;
+                canonicalQueue[head++] = e->inverse;
+            }
+            e = mirror ? e->prev : e->next;
+        } while (e != entry);
+    }
+    
+    certificate[0] = nv;
+    certificate[1] = ni;
+    pos = 2;
+    for(i = 0; i < nv + ni; i++){
+        e = elast = canonicalEntries[i];
+        do {
+            certificate[pos] = canonicalLabels[e->end];
+            if(!smaller){
+                if(certificate[pos] > best[pos]){
+                    return FALSE;
+                } else if(certificate[pos] < best[pos]){
+                    smaller = TRUE;
+                }
+            }
+            pos++;
+            e = mirror ? e->prev : e->next;
+        } while (e != elast);
+        certificate[pos] = -1;
+        if(!smaller && best[pos] != -1){
+            //best has more neighbours for this vertex
+            smaller = TRUE;
+        }
+        pos++;
+    }
+    return smaller;
+}
+
+/* Returns a hash of the certificate, using FNV-1a.
+ */
+unsigned long long int hashCertificate(int *certificate, int length){
+    int i;
+    unsigned long long int hash = 14695981039346656037ULL;
+    
+    for(i = 0; i < length; i++){
+        hash ^= (unsigned int) certificate[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* The caller should hold isomorphismMutex.
+ */
+void growIsomorphismClasses(){
+    size_t i, slot;
+    size_t oldSize = isomorphismClassesSize;
+    ISOMORPHISMCLASS *oldClasses = isomorphismClasses;
+    
+    isomorphismClassesSize = oldSize == 0 ? 1024 : 2*oldSize;
+    isomorphismClasses = calloc(isomorphismClassesSize, sizeof(ISOMORPHISMCLASS));
+    if(isomorphismClasses == NULL){
+        fprintf(stderr, "Insufficient memory for isomorphism classes -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < oldSize; i++){
+        if(oldClasses[i].certificate != NULL){
+            slot = oldClasses[i].hash & (isomorphismClassesSize - 1);
+            while(isomorphismClasses[slot].certificate != NULL){
+                slot = (slot + 1) & (isomorphismClassesSize - 1);
+            }
+            isomorphismClasses[slot] = oldClasses[i];
+        }
+    }
+    free(oldClasses);
+}
+
+/* Returns TRUE if the current thrackle is not isomorphic to an embedding that
+ * was handled before, and remembers it. Only the vertices of the input graph
+ * are used as start, since an isomorphism maps vertices to vertices.
+ */
+boolean isNewIsomorphismClass(){
+    int i, length;
+    size_t slot;
+    unsigned long long int hash;
+    boolean mirror;
+    EDGE *e, *elast;
+    
+    getCanonicalCandidate(firstedge[0], FALSE, canonicalCertificate, NULL);
+    for(i = 0; i < nv; i++){
+        e = elast = firstedge[i];
+        do {
+            for(mirror = FALSE; mirror <= TRUE; mirror++){
+                if(getCanonicalCandidate(e, mirror, alternativeCertificate, canonicalCertificate)){
+                    int *smallest = alternativeCertificate;
+                    alternativeCertificate = canonicalCertificate;
+                    canonicalCertificate = smallest;
+                }
+            }
+            e = e->next;
+        } while (e != elast);
+    }
+    length = 2 + nv + ni + crossGraphEdgeCounter;
+    hash = hashCertificate(canonicalCertificate, length);
+    
+    pthread_mutex_lock(&isomorphismMutex);
+    if(2*(isomorphismClassesStored + 1) > isomorphismClassesSize){
+        growIsomorphismClasses();
+    }
+    slot = hash & (isomorphismClassesSize - 1);
+    while(isomorphismClasses[slot].certificate != NULL){
+        int *stored = isomorphismClasses[slot].certificate;
+        if(isomorphismClasses[slot].hash == hash && stored[0] == length &&
+                memcmp(stored + 1, canonicalCertificate, sizeof(int) * length) == 0){
+            pthread_mutex_unlock(&isomorphismMutex);
+            return FALSE;
+        }
+        slot = (slot + 1) & (isomorphismClassesSize - 1);
+    }
+    int *stored = malloc(sizeof(int) * (length + 1));
+    if(stored == NULL){
+        fprintf(stderr, "Insufficient memory for isomorphism classes -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    stored[0] = length;
+    memcpy(stored + 1, canonicalCertificate, sizeof(int) * length);
+    isomorphismClasses[slot].hash = hash;
+    isomorphismClasses[slot].certificate = stored;
+    isomorphismClassesStored++;
+    isomorphismClassCount++;
+    pthread_mutex_unlock(&isomorphismMutex);
+    return TRUE;
+}
+
+//=============== Deduplicating split states ===========================
+
+/* Stores the certificate of the partial embedding at the split level that is
+ * obtained by a breadth-first search starting from the half-edge start, as in
+ * getCanonicalCandidate. The vertices that still get edges keep their labels,
+ * the other vertices and the intersections are numbered separately in the
+ * order in which they are reached. The certificate consists of the neighbours
+ * of the vertices that still get edges, followed by those of the other
+ * vertices and the intersections, each terminated by -1.
+ * 
+ * If best is not NULL, the construction stops as soon as the certificate is
+ * known not to be smaller than best. Returns TRUE if a certificate was stored
+ * that is smaller than best.
+ */
+boolean getSplitStateCandidate(EDGE *start, boolean mirror, int *certificate, int *best){
+    int i, pos, head, tail, vertexLabel, intersectionLabel;
+    boolean smaller = best == NULL;
+    EDGE *e, *elast;
+    
+    for(i = 0; i < nv + intersectionCounter; i++){
+        splitStateLabels[i] = -1;
+    }
+    
+    splitStateLabels[start->start] = start->start;
+    splitStateEntries[start->start] = start;
+    vertexLabel = nv;
+    intersectionLabel = nv + deadVertexCount;
+    head = tail = 0;
+    splitStateQueue[head++] = start;
+    
+    while(tail < head){
+        EDGE *entry = splitStateQueue[tail++];
+        e = entry;
+        do {
+            if(splitStateLabels[e->end] == -1){
+                int label;
+                if(IS_INTERSECTION(e->end)){
+                    label = intersectionLabel++;
+                } else if(liveVertex[e->end]){
+                    label = e->end;
+                } else {
+                    label = vertexLabel++;
+                }
+                splitStateLabels[e->end] = label;
+                splitStateEntries[label] = e->inverse;
+                splitStateQueue[head++] = e->inverse;
+            }
+            e = mirror ? e->prev : e->next;
+        } while (e != entry);
+    }
+    
+    pos = 0;
+    for(i = 0; i < intersectionLabel; i++){
+        if(i >= nv || (liveVertex[i] && degree[i] > 0)){
+            e = elast = splitStateEntries[i];
+            do {
+                certificate[pos] = splitStateLabels[e->end];
+                if(!smaller){
+                    if(certificate[pos] > best[pos]){
+                        return FALSE;
+                    } else if(certificate[pos] < best[pos]){
+                        smaller = TRUE;
+                    }
+                }
+                pos++;
+                e = mirror ? e->prev : e->next;
+            } while (e != elast);
+        }
+        certificate[pos] = -1;
+        if(!smaller && best[pos] != -1){
+            //best has more neighbours for this vertex
+            smaller = TRUE;
+        }
+        pos++;
+    }
+    return smaller;
+}
+
+/* The table of split states belongs to the current graph.
+ */
+void clearSplitStates(){
+    size_t i;
+    
+    for(i = 0; i < splitStatesSize; i++){
+        free(splitStates[i].counts);
+    }
+    free(splitStates);
+    splitStates = NULL;
+    splitStatesSize = 0;
+    splitStatesStored = 0;
+}
+
+void growSplitStates(){
+    size_t i, slot;
+    size_t oldSize = splitStatesSize;
+    SPLITSTATE *oldStates = splitStates;
+    
+    splitStatesSize = oldSize == 0 ? 1024 : 2*oldSize;
+    splitStates = calloc(splitStatesSize, sizeof(SPLITSTATE));
+    if(splitStates == NULL){
+        fprintf(stderr, "Insufficient memory for split states -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < oldSize; i++){
+        if(oldStates[i].certificate != NULL){
+            slot = oldStates[i].hash & (splitStatesSize - 1);
+            while(splitStates[slot].certificate != NULL){
+                slot = (slot + 1) & (splitStatesSize - 1);
+            }
+            splitStates[slot] = oldStates[i];
+        }
+    }
+    free(oldStates);
+}
+
+/* Marks the vertices that still get edges at or after the split level and
+ * empties the table of split states.
+ */
+void prepareSplitStates(){
+    int i;
+    
+    for(i = 0; i < nv; i++){
+        liveVertex[i] = FALSE;
+    }
+    for(i = splitLevel; i < edgeCount; i++){
+        liveVertex[numberedEdges[i][0]] = liveVertex[numberedEdges[i][1]] = TRUE;
+    }
+    deadVertexCount = 0;
+    for(i = 0; i < nv; i++){
+        if(!liveVertex[i]){
+            deadVertexCount++;
+        }
+    }
+    clearSplitStates();
+    splitStatesSearched = 0;
+    splitStatesSkipped = 0;
+}
+
+/* Called instead of splitting when the search reaches the split level. If the
+ * current partial embedding is isomorphic to a state of which the subtree was
+ * already searched, the numbers of embeddings of that subtree are added to the
+ * counts. Otherwise the subtree is searched and its numbers are stored. The
+ * vertex from of the next edge is embedded and keeps its label, so only the
+ * half-edges at that vertex are used as start.
+ */
+void deduplicateSplitState(){
+    int i, length;
+    int level = splitLevel;
+    int levels = edgeCount - splitLevel + 1;
+    size_t slot;
+    unsigned long long int hash;
+    unsigned long long int *counts;
+    boolean mirror;
+    EDGE *e, *elast;
+    
+    e = elast = firstedge[numberedEdges[splitLevel][0]];
+    getSplitStateCandidate(e, FALSE, splitStateCertificate, NULL);
+    do {
+        for(mirror = FALSE; mirror <= TRUE; mirror++){
+            if(getSplitStateCandidate(e, mirror, alternativeSplitStateCertificate, splitStateCertificate)){
+                int *smallest = alternativeSplitStateCertificate;
+                alternativeSplitStateCertificate = splitStateCertificate;
+                splitStateCertificate = smallest;
+            }
+        }
+        e = e->next;
+    } while (e != elast);
+    length = nv + deadVertexCount + intersectionCounter + crossGraphEdgeCounter;
+    hash = hashCertificate(splitStateCertificate, length);
+    
+    if(2*(splitStatesStored + 1) > splitStatesSize){
+        growSplitStates();
+    }
+    slot = hash & (splitStatesSize - 1);
+    while(splitStates[slot].certificate != NULL){
+        int *stored = splitStates[slot].certificate;
+        if(splitStates[slot].hash == hash && stored[0] == length &&
+                memcmp(stored + 1, splitStateCertificate, sizeof(int) * length) == 0){
+            counts = splitStates[slot].counts;
+            for(i = splitLevel; i < edgeCount; i++){
+                edgeEmbeddings[i] += counts[i - splitLevel];
+            }
+            numberOfThrackles += counts[levels - 1];
+            splitStatesSkipped++;
+            return;
+        }
+        slot = (slot + 1) & (splitStatesSize - 1);
+    }
+    
+    //the counts are first used for the numbers before the subtree is searched
+    counts = malloc(sizeof(unsigned long long int) * levels + sizeof(int) * (length + 1));
+    if(counts == NULL){
+        fprintf(stderr, "Insufficient memory for split states -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = splitLevel; i < edgeCount; i++){
+        counts[i - splitLevel] = edgeEmbeddings[i];
+    }
+    counts[levels - 1] = numberOfThrackles;
+    
+    splitLevel = -1;
+    doNextEdge();
+    splitLevel = level;
+    
+    for(i = splitLevel; i < edgeCount; i++){
+        counts[i - splitLevel] = edgeEmbeddings[i] - counts[i - splitLevel];
+    }
+    counts[levels - 1] = numberOfThrackles - counts[levels - 1];
+    int *stored = (int *) (counts + levels);
+    stored[0] = length;
+    memcpy(stored + 1, splitStateCertificate, sizeof(int) * length);
+    splitStates[slot].hash = hash;
+    splitStates[slot].certificate = stored;
+    splitStates[slot].counts = counts;
+    splitStatesStored++;
+    splitStatesSearched++;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+/* Called at a choice point during a random probe with the number of
+ * alternatives that can be chosen. One of them is chosen at random and its
+ * index among these alternatives is returned. The estimate of the size of the
+ * search tree is updated as in Knuth's method.
+ */
+int probeChoice(int depth, int alternatives){
+    //the range at this depth is reset by finishChoice
+    choiceRestricted = depth;
+    if(alternatives == 0){
+        choiceFirst[depth] = INT_MAX;
+        return -1;
+    }
+    probeWeight *= alternatives;
+    probeNodes += probeWeight;
+    probeSteps++;
+    return rand_r(&probeSeed) % alternatives;
+}
+
+void handleThrackle(){
+    if(probing){
+        probeEmbeddings += probeWeight;
+        return;
+    }
+    if(testCommonPart){
+        return;
+    }
+    numberOfThrackles++;
+    if(breakSymmetry){
+        labelledNumberOfThrackles += symmetryCount / stabilizerSize;
+    }
+    ni = intersectionCounter;
+    if(nonIsomorphic && !isNewIsomorphismClass()){
+        return;
+    }
+    if(!censusMode && !countOnly){
+        writeThrackleCode();
+    }
+    if(justOne){
+        if(threadCount > 1){
+            //only the first thread to get here writes its embedding
+            pthread_mutex_lock(&outputMutex);
+            if(searchStopped){
+                numberOfThrackles--;
+                if(breakSymmetry){
+                    labelledNumberOfThrackles -= symmetryCount / stabilizerSize;
+                }
+            } else {
+                searchStopped = TRUE;
+                workRequested = TRUE;
+                if(!orderedHeaderWritten){
+                    orderedHeaderWritten = TRUE;
+                    appendCodeOutput(&standardOutput, ">>thrackle_code<<", 17);
+                }
+                appendCodeOutput(&standardOutput, outputChunk.buffer, outputChunk.size);
+                outputChunk.size = 0;
+            }
+            pthread_mutex_unlock(&outputMutex);
+        }
+        stopSearch();
+        return;
+    }
+    if(threadCount > 1 && outputChunk.size > OUTPUT_CHUNK_SIZE){
+        rotateOutputChunk();
+    }
+}
+
+static inline void setEdgeOnTrail(EDGE **address, EDGE *value){
+    edgeTrail[edgeTrailSize].address = address;
+    edgeTrail[edgeTrailSize++].value = *address;
+    *address = value;
+}
+
+static inline void setIntOnTrail(int *address, int value){
+    intTrail[intTrailSize].address = address;
+    intTrail[intTrailSize++].value = *address;
+    *address = value;
+}
+
+/* Undoes all changes that were recorded after the trails had the given sizes.
+ */
+static inline void undoTrail(int edgeTrailMark, int intTrailMark){
+    while(edgeTrailSize > edgeTrailMark){
+        edgeTrailSize--;
+        *(edgeTrail[edgeTrailSize].address) = edgeTrail[edgeTrailSize].value;
+    }
+    while(intTrailSize > intTrailMark){
+        intTrailSize--;
+        *(intTrail[intTrailSize].address) = intTrail[intTrailSize].value;
+    }
+}
+
+/* Returns the number of half-edges on the face to the right of start.
+ */
+int faceSize(EDGE *start){
+    int size = 0;
+    EDGE *e = start;
+    do {
+        size++;
+        e = e->inverse->prev;
+    } while (e != start);
+    return size;
+}
+
+//instantiate the search for each width of bitsets
+
+#define SEARCH_WIDTH 32
+#define bitset unsigned int
+#include "thrackler_search.h"
+#undef bitset
+#undef SEARCH_WIDTH
+
+#define SEARCH_WIDTH 64
+#define bitset unsigned long long int
+#include "thrackler_search.h"
+#undef bitset
+#undef SEARCH_WIDTH
+
+#undef SIZE
+#define SIZE(s) (__builtin_popcountll((unsigned long long int)(s)) + \
+        __builtin_popcountll((unsigned long long int)((s) >> 64)))
+
+#define SEARCH_WIDTH 128
+#define bitset unsigned __int128
+#include "thrackler_search.h"
+#undef bitset
+#undef SEARCH_WIDTH
+
+//wider bitsets consist of several words
+#undef IS_NOT_EMPTY
+#undef CONTAINS
+#undef REMOVE
+#undef MINUS
+#undef ALL_UP_TO
+#undef SIZE
+#define IS_NOT_EMPTY(s) ((s).word[0] | (s).word[1] | (s).word[2] | (s).word[3])
+#define CONTAINS(s, el) ((s).word[(el) >> 6] & (1ULL << ((el) & 63)))
+#define REMOVE(s, el) ((s).word[(el) >> 6] ^= (1ULL << ((el) & 63)))
+#define MINUS(s, el) minus256(s, el)
+#define ALL_UP_TO(el) allUpTo256(el)
+#define SIZE(s) (__builtin_popcountll((s).word[0]) + __builtin_popcountll((s).word[1]) + \
+        __builtin_popcountll((s).word[2]) + __builtin_popcountll((s).word[3]))
+
+#define SEARCH_WIDTH 256
+#define bitset bitset256
+#include "thrackler_search.h"
+#undef bitset
+#undef SEARCH_WIDTH
+
+/* Selects the search that uses the smallest bitsets that can contain all edges.
+ */
+void selectSearch(){
+    if(edgeCount <= 32){
+        doNextEdge = iterativeSearch ? searchIteratively_32 : doNextEdge_32;
+    } else if(edgeCount <= 64){
+        doNextEdge = iterativeSearch ? searchIteratively_64 : doNextEdge_64;
+    } else if(edgeCount <= 128){
+        doNextEdge = iterativeSearch ? searchIteratively_128 : doNextEdge_128;
+    } else {
+        doNextEdge = iterativeSearch ? searchIteratively_256 : doNextEdge_256;
+    }
+}
+
+void startThrackling(){
+    int i, from, to;
+    
+    intersectionCounter = 0;
+    crossGraphEdgeCounter = 0;
+    edgeCounter = 0;
+    
+    //graphs with at most two edges have a unique embedding
+    stabilizerSize = symmetryCount;
+    
+    for(i = 0; i < nv + intersectionCount; i++){
+        firstedge[i] = NULL;
+        degree[i] = 0;
+    }
+    
+    //first edge
+    from = numberedEdges[edgeCounter][0];
+    to = numberedEdges[edgeCounter][1];
+    
+    EDGE *firstEdge = edges + crossGraphEdgeCounter++;
+    firstEdge->edgeNumber = edgeCounter;
+    firstEdge->start = from;
+    firstEdge->end = to;
+    firstEdge->next = firstEdge->prev = firstEdge;
+    EDGE *inverseFirstEdge = edges + crossGraphEdgeCounter++;
+    inverseFirstEdge->edgeNumber = edgeCounter;
     inverseFirstEdge->start = to;
     inverseFirstEdge->end = from;
-    inverseFirstEdge->startType = inverseFirstEdge->endType = VERTEX;
     inverseFirstEdge->next = inverseFirstEdge->prev = inverseFirstEdge;
     
     firstEdge->inverse = inverseFirstEdge;
@@ -514,7 +1711,6 @@ void startThrackling(){
     secondEdge->edgeNumber = edgeCounter;
     secondEdge->start = from;
     secondEdge->end = to;
-    secondEdge->startType = secondEdge->endType = VERTEX;
     if(degree[from]==0){
         secondEdge->next = secondEdge->prev = secondEdge;
         firstedge[from] = secondEdge;
@@ -526,7 +1722,6 @@ void startThrackling(){
     inverseSecondEdge->edgeNumber = edgeCounter;
     inverseSecondEdge->start = to;
     inverseSecondEdge->end = from;
-    inverseSecondEdge->startType = inverseSecondEdge->endType = VERTEX;
     if(degree[to]==0){
        inverseSecondEdge->next = inverseSecondEdge->prev = inverseSecondEdge;
        firstedge[to] = inverseSecondEdge;
@@ -548,166 +1743,3618 @@ void startThrackling(){
         return;
     }
     
-    doNextEdge();
+    doNextEdge();
+}
+
+//=============== Search state ===========================
+
+/* The search state of a graph is stored in a single arena, so it is sized for
+ * the graph at hand and the arrays that are used together share few cache
+ * lines. Every array in the arena starts at a cache line.
+ */
+#define CACHE_LINE_SIZE 64
+
+THREADLOCAL char *searchStateArena;
+
+/* Returns the address at which an array of the given size starts in the arena
+ * and moves offset past it. If arena is NULL, only the offset is computed.
+ */
+void *takeFromArena(char *arena, size_t *offset, size_t size){
+    size_t start = (*offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    
+    *offset = start + size;
+    return arena == NULL ? NULL : arena + start;
+}
+
+/* Assigns the arrays of the search state to their places in the arena and
+ * returns the size of the arena.
+ */
+size_t layOutSearchState(char *arena, int closingEdges){
+    size_t offset = 0;
+    int vertices = nv + intersectionCount;
+    int halfEdges = 2*(edgeCount + 2*intersectionCount);
+    int maxDepth = edgeCount + intersectionCount + 1;
+    
+    //the cross graph
+    edges = takeFromArena(arena, &offset, sizeof(EDGE) * halfEdges);
+    firstedge = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+    degree = takeFromArena(arena, &offset, sizeof(int) * vertices);
+    
+    //the choice points
+    choicePath = takeFromArena(arena, &offset, sizeof(int) * maxDepth);
+    choiceFirst = takeFromArena(arena, &offset, sizeof(int) * maxDepth);
+    choiceLast = takeFromArena(arena, &offset, sizeof(int) * maxDepth);
+    choiceDonated = takeFromArena(arena, &offset, sizeof(SEARCHTASK *) * maxDepth);
+    
+    //the face labels
+    faceLabelSize = halfEdges + 1;
+    halfEdgeFaceLevels = takeFromArena(arena, &offset, sizeof(int) * faceLabelSize * (closingEdges + 1));
+    faceDistanceLevels = takeFromArena(arena, &offset, sizeof(int) * faceLabelSize * (closingEdges + 1));
+    faceQueue = takeFromArena(arena, &offset, sizeof(EDGE *) * 2 * halfEdges);
+    faceQueueDistance = takeFromArena(arena, &offset, sizeof(int) * 2 * halfEdges);
+    
+    if(breakSymmetry){
+        int certificateSize = halfEdges + vertices;
+        symmetryState = takeFromArena(arena, &offset, sizeof(int) * (edgeCount + 1) * symmetryCount);
+        symmetryCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        symmetryImageCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        symmetryLabels = takeFromArena(arena, &offset, sizeof(int) * vertices);
+        symmetryEntries = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+        symmetryQueue = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+    }
+    
+    if(nonIsomorphic){
+        int certificateSize = 2 + halfEdges + vertices;
+        canonicalCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        alternativeCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        canonicalLabels = takeFromArena(arena, &offset, sizeof(int) * vertices);
+        canonicalEntries = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+        canonicalQueue = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+    }
+    
+    if(deduplicateSplitStates){
+        int certificateSize = halfEdges + 2*nv + intersectionCount;
+        liveVertex = takeFromArena(arena, &offset, sizeof(boolean) * nv);
+        splitStateCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        alternativeSplitStateCertificate = takeFromArena(arena, &offset, sizeof(int) * certificateSize);
+        splitStateLabels = takeFromArena(arena, &offset, sizeof(int) * vertices);
+        splitStateEntries = takeFromArena(arena, &offset, sizeof(EDGE *) * (nv + vertices));
+        splitStateQueue = takeFromArena(arena, &offset, sizeof(EDGE *) * vertices);
+    }
+    
+    return offset;
+}
+
+/* Allocates the search state for the current graph. This requires the edge
+ * order and the counts of the graph.
+ */
+void allocateGraphSearchState(){
+    int i;
+    int closingEdges = 0;
+    int maxDepth = edgeCount + intersectionCount + 1;
+    boolean embedded[nv];
+    void *arena;
+    
+    //count the edges that end in a vertex that is already embedded
+    for(i = 0; i < nv; i++){
+        embedded[i] = FALSE;
+    }
+    for(i = 0; i < edgeCount; i++){
+        if(embedded[numberedEdges[i][1]]){
+            closingEdges++;
+        }
+        embedded[numberedEdges[i][0]] = embedded[numberedEdges[i][1]] = TRUE;
+    }
+    
+    if(posix_memalign(&arena, CACHE_LINE_SIZE, layOutSearchState(NULL, closingEdges))){
+        fprintf(stderr, "Insufficient memory for search state -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    searchStateArena = arena;
+    layOutSearchState(searchStateArena, closingEdges);
+    faceLabelLevel = 0;
+    
+    for(i = 0; i < maxDepth; i++){
+        choiceFirst[i] = 0;
+        choiceLast[i] = INT_MAX;
+        choiceDonated[i] = NULL;
+    }
+    choiceDepth = 0;
+}
+
+void freeGraphSearchState(){
+    free(searchStateArena);
+    searchStateArena = NULL;
+}
+
+//=============== Multithreaded search ===========================
+
+/* The search tree is distributed over the threads as tasks. A task is a path
+ * from the root to a choice point together with a range of alternatives at
+ * that choice point. A thread that runs a task replays the path and explores
+ * the alternatives in the range. When a thread is idle, a working thread will
+ * give away the remaining alternatives of its shallowest choice point that
+ * still has any. The output of each task is a list of chunks in which the
+ * output of a donated task is inserted as a single chunk, so the output can be
+ * written in the same order as in a single-threaded run.
+ */
+
+SEARCHTASK *newTask(int depth, int *path, int first, int last, SEARCHTASK *parent){
+    int i;
+    SEARCHTASK *task = malloc(sizeof(SEARCHTASK));
+    
+    if(task == NULL){
+        fprintf(stderr, "Insufficient memory for tasks -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    task->depth = depth;
+    task->path = malloc(sizeof(int) * (depth + 1));
+    for(i = 0; i < depth; i++){
+        task->path[i] = path[i];
+    }
+    task->first = first;
+    task->last = last;
+    task->finished = FALSE;
+    task->firstChunk = task->lastChunk = NULL;
+    task->parent = parent;
+    task->nextInQueue = NULL;
+    
+    return task;
+}
+
+/* The caller should hold outputMutex.
+ */
+void appendOutputChunk(SEARCHTASK *task, char *data, size_t size, SEARCHTASK *child){
+    OUTPUTCHUNK *chunk = malloc(sizeof(OUTPUTCHUNK));
+    
+    if(chunk == NULL){
+        fprintf(stderr, "Insufficient memory for output -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    chunk->data = data;
+    chunk->size = size;
+    chunk->task = child;
+    chunk->next = NULL;
+    
+    if(task->lastChunk == NULL){
+        task->firstChunk = task->lastChunk = chunk;
+    } else {
+        task->lastChunk->next = chunk;
+        task->lastChunk = chunk;
+    }
+}
+
+/* The caller should hold outputMutex.
+ */
+void removeFirstOutputChunk(SEARCHTASK *task){
+    OUTPUTCHUNK *chunk = task->firstChunk;
+    
+    task->firstChunk = chunk->next;
+    if(task->firstChunk == NULL){
+        task->lastChunk = NULL;
+    }
+    free(chunk);
+}
+
+void openOutputChunk(){
+    openCodeOutput(&outputChunk, -1, OUTPUT_CHUNK_START_SIZE);
+    thrackleOutput = &outputChunk;
+}
+
+/* Closes the current output chunk and appends it to the current task.
+ * The caller should hold outputMutex.
+ */
+void closeOutputChunk(){
+    if(outputChunk.size == 0){
+        free(outputChunk.buffer);
+    } else {
+        appendOutputChunk(currentTask, (char *)outputChunk.buffer, outputChunk.size, NULL);
+    }
+    outputChunk.buffer = NULL;
+}
+
+/* Writes all output that is complete up to the first task that is still
+ * running. The caller should hold outputMutex.
+ */
+void writeOrderedOutput(){
+    while(writerTask != NULL){
+        OUTPUTCHUNK *chunk = writerTask->firstChunk;
+        if(chunk == NULL){
+            if(!writerTask->finished){
+                return;
+            }
+            //all output of this task has been written
+            SEARCHTASK *parent = writerTask->parent;
+            free(writerTask);
+            writerTask = parent;
+            if(parent != NULL){
+                removeFirstOutputChunk(parent);
+            }
+        } else if(chunk->task != NULL){
+            writerTask = chunk->task;
+        } else if(searchStopped){
+            //the embedding that stopped the search has already been written
+            free(chunk->data);
+            removeFirstOutputChunk(writerTask);
+        } else {
+            if(!orderedHeaderWritten){
+                orderedHeaderWritten = TRUE;
+                appendCodeOutput(&standardOutput, ">>thrackle_code<<", 17);
+            }
+            appendCodeOutput(&standardOutput, chunk->data, chunk->size);
+            free(chunk->data);
+            removeFirstOutputChunk(writerTask);
+        }
+    }
+}
+
+void rotateOutputChunk(){
+    pthread_mutex_lock(&outputMutex);
+    closeOutputChunk();
+    writeOrderedOutput();
+    pthread_mutex_unlock(&outputMutex);
+    openOutputChunk();
+}
+
+/* The caller should hold taskMutex.
+ */
+void pushTask(SEARCHTASK *task){
+    if(taskQueueTail == NULL){
+        taskQueueHead = taskQueueTail = task;
+    } else {
+        taskQueueTail->nextInQueue = task;
+        taskQueueTail = task;
+    }
+    queuedTasks++;
+    workRequested = searchStopped || idleThreads > queuedTasks;
+    pthread_cond_signal(&taskAvailable);
+}
+
+/* Returns the next task, or NULL if the search is finished.
+ */
+SEARCHTASK *takeTask(){
+    SEARCHTASK *task;
+    
+    pthread_mutex_lock(&taskMutex);
+    idleThreads++;
+    while(taskQueueHead == NULL && !searchFinished){
+        if(idleThreads == threadCount){
+            //nobody is working, so no new tasks can appear
+            searchFinished = TRUE;
+            pthread_cond_broadcast(&taskAvailable);
+        } else {
+            workRequested = TRUE;
+            pthread_cond_wait(&taskAvailable, &taskMutex);
+        }
+    }
+    if(searchFinished){
+        workRequested = FALSE;
+        pthread_mutex_unlock(&taskMutex);
+        return NULL;
+    }
+    task = taskQueueHead;
+    taskQueueHead = task->nextInQueue;
+    if(taskQueueHead == NULL){
+        taskQueueTail = NULL;
+    }
+    queuedTasks--;
+    idleThreads--;
+    workRequested = searchStopped || idleThreads > queuedTasks;
+    pthread_mutex_unlock(&taskMutex);
+    
+    return task;
+}
+
+/* Called at a choice point when another thread is idle: hands the remaining
+ * alternatives of the shallowest choice point over to a new task.
+ */
+void donateWork(){
+    int depth;
+    
+    if(checkpointRequested){
+        writeCheckpoint(FALSE);
+    }
+    
+    if(progressRequested){
+        pthread_mutex_lock(&progressMutex);
+        if(progressRequested){
+            progressRequested = FALSE;
+            printProgress();
+        }
+        pthread_mutex_unlock(&progressMutex);
+    }
+    
+    if(heartbeatRequested){
+        sendHeartbeat();
+    }
+    
+    if(unitCancelled){
+        //another worker searches this unit
+        stopSearch();
+        return;
+    }
+    
+    if(currentTask == NULL){
+        //not a multithreaded search
+        workRequested = checkpointRequested || progressRequested || heartbeatRequested;
+        return;
+    }
+    
+    if(searchStopped){
+        stopSearch();
+        return;
+    }
+    
+    pthread_mutex_lock(&taskMutex);
+    if(idleThreads > queuedTasks){
+        for(depth = currentTask->depth; depth < choiceDepth; depth++){
+            if(choicePath[depth] < choiceLast[depth]){
+                SEARCHTASK *task = newTask(depth, choicePath,
+                        choicePath[depth] + 1, choiceLast[depth], currentTask);
+                choiceLast[depth] = choicePath[depth];
+                choiceDonated[depth] = task;
+                if(depth > choiceRestricted){
+                    choiceRestricted = depth;
+                }
+                pushTask(task);
+                break;
+            }
+        }
+    }
+    workRequested = searchStopped || idleThreads > queuedTasks || progressRequested;
+    pthread_mutex_unlock(&taskMutex);
+}
+
+/* Makes the loops at all current choice points end after the current
+ * alternative.
+ */
+void stopSearch(){
+    int depth;
+    
+    for(depth = 0; depth < choiceDepth; depth++){
+        choiceLast[depth] = -1;
+    }
+    choiceRestricted = choiceDepth - 1;
+}
+
+/* Called when the loop at a choice point with a restricted range is finished.
+ */
+void finishChoice(int depth){
+    if(choiceDonated[depth] != NULL){
+        //the output of the donated alternatives follows the output so far
+        pthread_mutex_lock(&outputMutex);
+        closeOutputChunk();
+        appendOutputChunk(currentTask, NULL, 0, choiceDonated[depth]);
+        pthread_mutex_unlock(&outputMutex);
+        openOutputChunk();
+        choiceDonated[depth] = NULL;
+    }
+    choiceFirst[depth] = 0;
+    choiceLast[depth] = INT_MAX;
+    choiceRestricted = depth - 1;
+}
+
+void runTask(SEARCHTASK *task){
+    int i;
+    int depth = task->depth;
+    
+    currentTask = task;
+    countFromDepth = task->parent == NULL ? 0 : depth + 1;
+    for(i = 0; i < depth; i++){
+        choiceFirst[i] = choiceLast[i] = task->path[i];
+    }
+    choiceFirst[depth] = task->first;
+    choiceLast[depth] = task->last;
+    choiceRestricted = depth;
+    free(task->path);
+    task->path = NULL;
+    
+    openOutputChunk();
+    if(!searchStopped){
+        startThrackling();
+    }
+    
+    for(i = 0; i <= depth; i++){
+        choiceFirst[i] = 0;
+        choiceLast[i] = INT_MAX;
+    }
+    choiceRestricted = -1;
+    
+    pthread_mutex_lock(&outputMutex);
+    closeOutputChunk();
+    task->finished = TRUE;
+    writeOrderedOutput();
+    pthread_mutex_unlock(&outputMutex);
+    currentTask = NULL;
+}
+
+/* Copies the description of the graph from the thread that started the search.
+ * The automorphisms are shared.
+ */
+void loadGraphState(GRAPHSTATE *graphState){
+    nv = graphState->nv;
+    edgeCount = graphState->edgeCount;
+    intersectionCount = graphState->intersectionCount;
+    memcpy(numberedEdges, graphState->numberedEdges, sizeof(int) * 2 * edgeCount);
+    useAutomorphisms = graphState->useAutomorphisms;
+    automorphismCount = graphState->automorphismCount;
+    symmetryCount = graphState->symmetryCount;
+    automorphisms = graphState->automorphisms;
+    edgeAutomorphisms = graphState->edgeAutomorphisms;
+    comparableLevel = graphState->comparableLevel;
+    symmetryStartVertex = graphState->symmetryStartVertex;
+    symmetryStartEdge = graphState->symmetryStartEdge;
+}
+
+void storeGraphState(GRAPHSTATE *graphState){
+    graphState->nv = nv;
+    graphState->edgeCount = edgeCount;
+    graphState->intersectionCount = intersectionCount;
+    graphState->numberedEdges = numberedEdges;
+    graphState->useAutomorphisms = useAutomorphisms;
+    graphState->automorphismCount = automorphismCount;
+    graphState->symmetryCount = symmetryCount;
+    graphState->automorphisms = automorphisms;
+    graphState->edgeAutomorphisms = edgeAutomorphisms;
+    graphState->comparableLevel = comparableLevel;
+    graphState->symmetryStartVertex = symmetryStartVertex;
+    graphState->symmetryStartEdge = symmetryStartEdge;
+}
+
+void *searchWorker(void *arg){
+    int i;
+    SEARCHTASK *task;
+    
+    loadGraphState((GRAPHSTATE *) arg);
+    selectSearch();
+    allocateGraphSearchState();
+    pthread_mutex_lock(&progressMutex);
+    searcherNodes[searcherCount] = edgeNodes;
+    searcherThrackles[searcherCount++] = &numberOfThrackles;
+    pthread_mutex_unlock(&progressMutex);
+    //the header is written by writeOrderedOutput
+    thrackleCodeHeaderWritten = TRUE;
+    
+    while((task = takeTask()) != NULL){
+        runTask(task);
+    }
+    
+    pthread_mutex_lock(&taskMutex);
+    totalNumberOfThrackles += numberOfThrackles;
+    totalLabelledNumberOfThrackles += labelledNumberOfThrackles;
+    for(i = 0; i < edgeCount; i++){
+        totalEdgeEmbeddings[i] += edgeEmbeddings[i];
+    }
+    pthread_mutex_unlock(&taskMutex);
+    
+    freeGraphSearchState();
+    return NULL;
+}
+
+void startThreadedThrackling(){
+    int i;
+    pthread_t threads[threadCount];
+    GRAPHSTATE graphState;
+    
+    storeGraphState(&graphState);
+    
+    SEARCHTASK *root = newTask(0, NULL, 0, INT_MAX, NULL);
+    writerTask = root;
+    idleThreads = 0;
+    searchFinished = FALSE;
+    searchStopped = FALSE;
+    totalNumberOfThrackles = 0;
+    totalLabelledNumberOfThrackles = 0;
+    for(i = 0; i < edgeCount; i++){
+        totalEdgeEmbeddings[i] = 0;
+    }
+    pthread_mutex_lock(&taskMutex);
+    pushTask(root);
+    pthread_mutex_unlock(&taskMutex);
+    
+    for(i = 0; i < threadCount; i++){
+        if(pthread_create(threads + i, NULL, searchWorker, &graphState)){
+            fprintf(stderr, "Could not start thread -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for(i = 0; i < threadCount; i++){
+        pthread_join(threads[i], NULL);
+    }
+    
+    numberOfThrackles = totalNumberOfThrackles;
+    labelledNumberOfThrackles = totalLabelledNumberOfThrackles;
+    for(i = 0; i < edgeCount; i++){
+        edgeEmbeddings[i] = totalEdgeEmbeddings[i];
+    }
+}
+
+void numberEdge(int n, boolean isStored[][n+1], int from, int to){
+    numberedEdges[edgeCount][0] = from - 1;
+    numberedEdges[edgeCount][1] = to - 1;
+    edgeCount++;
+    isStored[from][to] = isStored[to][from] = TRUE;
+}
+
+/* Numbers the edges by handling the reached vertices one by one: when a vertex
+ * is handled, all its edges that are not yet numbered get the next numbers.
+ * The vertex that is handled next is the vertex that was reached last (dfs),
+ * the vertex that was reached first (bfs) or the reached vertex with the
+ * largest degree (degree).
+ */
+void orderEdgesByVertices(GRAPH graph, ADJACENCY adj, int strategy,
+        int n, boolean isReached[], boolean isStored[][n+1]){
+    int i, j;
+    int pending[n];
+    int head = 0, top = 0;
+    int first = 1;
+    
+    if(strategy == EDGE_ORDER_DEGREE){
+        for(i = 2; i <= n; i++){
+            if(adj[i] > adj[first]){
+                first = i;
+            }
+        }
+    }
+    pending[top++] = first;
+    isReached[first] = TRUE;
+    
+    while(head < top){
+        int current;
+        if(strategy == EDGE_ORDER_BFS){
+            current = pending[head++];
+        } else {
+            if(strategy == EDGE_ORDER_DEGREE){
+                int largest = top - 1;
+                for(i = head; i < top - 1; i++){
+                    if(adj[pending[i]] > adj[pending[largest]]){
+                        largest = i;
+                    }
+                }
+                current = pending[largest];
+                pending[largest] = pending[top - 1];
+                pending[top - 1] = current;
+            }
+            current = pending[--top];
+        }
+        for(j = 0; j < adj[current]; j++){
+            int neighbour = graph[current][j];
+            if(!isReached[neighbour]){
+                pending[top++] = neighbour;
+                isReached[neighbour] = TRUE;
+            }
+            if(!isStored[current][neighbour]){
+                numberEdge(n, isStored, current, neighbour);
+            }
+        }
+    }
+}
+
+/* Numbers the edges one by one. An edge between two reached vertices is
+ * preferred, since it closes a cycle. Otherwise the edge to the unreached
+ * vertex with the most reached neighbours is chosen.
+ */
+void orderEdgesByCycles(GRAPH graph, ADJACENCY adj,
+        int n, boolean isReached[], boolean isStored[][n+1]){
+    int u, v, j, k;
+    
+    isReached[1] = TRUE;
+    while(TRUE){
+        int bestFrom = 0, bestTo = 0, bestScore = -1;
+        for(u = 1; u <= n; u++){
+            if(!isReached[u]) continue;
+            for(j = 0; j < adj[u]; j++){
+                int score = 0;
+                v = graph[u][j];
+                if(isStored[u][v]) continue;
+                if(isReached[v]){
+                    score = n + 1;
+                } else {
+                    for(k = 0; k < adj[v]; k++){
+                        if(isReached[graph[v][k]]){
+                            score++;
+                        }
+                    }
+                }
+                if(score > bestScore){
+                    bestFrom = u;
+                    bestTo = v;
+                    bestScore = score;
+                }
+            }
+        }
+        if(bestScore < 0){
+            return;
+        }
+        numberEdge(n, isStored, bestFrom, bestTo);
+        isReached[bestTo] = TRUE;
+    }
+}
+
+/* Repeatedly numbers the edges of a shortest ear: a path between two reached
+ * vertices (or a cycle through one reached vertex) of which all internal
+ * vertices are unreached. If there is no ear, a single edge to an unreached
+ * vertex is numbered.
+ */
+void orderEdgesByEars(GRAPH graph, ADJACENCY adj,
+        int n, boolean isReached[], boolean isStored[][n+1]){
+    int u, x, y, j;
+    int parent[n+1], length[n+1];
+    boolean isSeen[n+1];
+    int queue[n];
+    int ear[n+1];
+    
+    isReached[1] = TRUE;
+    while(TRUE){
+        int earLength = INT_MAX;
+        int pendantFrom = 0, pendantTo = 0;
+        for(u = 1; u <= n; u++){
+            int head = 0, top = 0;
+            if(!isReached[u]) continue;
+            for(x = 1; x <= n; x++){
+                isSeen[x] = FALSE;
+            }
+            queue[top++] = u;
+            isSeen[u] = TRUE;
+            parent[u] = 0;
+            length[u] = 0;
+            while(head < top){
+                x = queue[head++];
+                for(j = 0; j < adj[x]; j++){
+                    y = graph[x][j];
+                    if(isStored[x][y] || (y == u && parent[x] == u)) continue;
+                    if(isReached[y]){
+                        if(length[x] + 1 < earLength){
+                            int v = x;
+                            earLength = length[x] + 1;
+                            ear[earLength] = y;
+                            while(v != 0){
+                                ear[length[v]] = v;
+                                v = parent[v];
+                            }
+                        }
+                    } else if(!isSeen[y]){
+                        if(pendantFrom == 0 && x == u){
+                            pendantFrom = x;
+                            pendantTo = y;
+                        }
+                        isSeen[y] = TRUE;
+                        parent[y] = x;
+                        length[y] = length[x] + 1;
+                        queue[top++] = y;
+                    }
+                }
+            }
+        }
+        if(earLength < INT_MAX){
+            for(j = 0; j < earLength; j++){
+                numberEdge(n, isStored, ear[j], ear[j+1]);
+                isReached[ear[j+1]] = TRUE;
+            }
+        } else if(pendantFrom != 0){
+            numberEdge(n, isStored, pendantFrom, pendantTo);
+            isReached[pendantTo] = TRUE;
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * Stores the edges in the array numberedEdges using the given strategy.
+ * The edges are numbered such that for each 0 <= i < #edges we have that
+ * the graph induced by the edges 0 up to i is connected and that the first
+ * vertex of edge i is incident with one of the edges 0 up to i-1.
+ * Returns FALSE if the graph cannot be handled.
+ */
+boolean orderEdgesWithStrategy(GRAPH graph, ADJACENCY adj, int strategy){
+    int i, j;
+    int n = graph[0][0];
+    int size = 0;
+    
+    usedEdgeOrder = strategy;
+    
+    //check the size before anything is sized for the graph
+    for(i = 1; i <= n; i++){
+        size += adj[i];
+    }
+    size /= 2;
+    if(size > MAXE){
+        fprintf(stderr, "Currently only supports up to %d edges.\n", MAXE);
+        return FALSE;
+    }
+    if(n > size + 1){
+        fprintf(stderr, "Input graph was not connected.\n");
+        return FALSE;
+    }
+    
+    edgeCount = 0;
+    boolean isStored[n+1][n+1];
+    boolean isVisited[n+1];
+    for(i = 1; i <= n; i++){
+        for(j = 1; j <= n; j++){
+            isStored[i][j] = FALSE;
+        }
+        isVisited[i] = FALSE;
+    }
+    
+    if(strategy == EDGE_ORDER_CYCLES){
+        orderEdgesByCycles(graph, adj, n, isVisited, isStored);
+    } else if(strategy == EDGE_ORDER_EARS){
+        orderEdgesByEars(graph, adj, n, isVisited, isStored);
+    } else {
+        orderEdgesByVertices(graph, adj, strategy, n, isVisited, isStored);
+    }
+    
+    //verify that the input graph was connected
+    for(i = 1; i <= graph[0][0]; i++){
+        if(!isVisited[i]){
+            fprintf(stderr, "Input graph was not connected.\n");
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+void calculateCounts(GRAPH graph, ADJACENCY adj){
+    int i;
+    //number of vertices
+    nv = graph[0][0];
+    //number of intersections
+    intersectionCount = edgeCount*edgeCount + edgeCount;
+    for(i = 1; i <= nv; i++){
+        intersectionCount -= adj[i]*adj[i];
+    }
+    intersectionCount /= 2;
+}
+
+/* Estimates the number of nodes in the search tree for the current edge
+ * numbering using random probes.
+ */
+double estimateTreeSize(GRAPH graph, ADJACENCY adj, int probes){
+    int i;
+    double total = 0;
+    int givenSplitLevel = splitLevel;
+    
+    calculateCounts(graph, adj);
+    if(breakSymmetry){
+        computeAutomorphisms(graph, adj);
+    }
+    selectSearch();
+    allocateGraphSearchState();
+    splitLevel = -1;
+    probing = TRUE;
+    probeSeed = 1;
+    for(i = 0; i < probes; i++){
+        probeWeight = 1;
+        probeNodes = 1;
+        startThrackling();
+        total += probeNodes;
+    }
+    probing = FALSE;
+    splitLevel = givenSplitLevel;
+    freeGraphSearchState();
+    if(breakSymmetry){
+        freeAutomorphisms();
+    }
+    
+    return total / probes;
+}
+
+/* Writes the mean of the given estimates with a 95% confidence interval. If
+ * the interval would reach below 0, the probes vary too much for a lower
+ * bound and this is written instead of clamping it.
+ */
+void printEstimate(char *name, double sum, double squareSum, int probes){
+    double mean = sum / probes;
+    double variance = probes > 1 ? (squareSum - sum * mean) / (probes - 1) : 0;
+    double margin = 1.96 * sqrt((variance > 0 ? variance : 0) / probes);
+    if(probes == 1){
+        fprintf(stderr, "  %-11s %.4g (no confidence interval from a single probe)\n", name, mean);
+    } else if(mean > margin){
+        fprintf(stderr, "  %-11s %.4g (95%% confidence interval %.4g - %.4g)\n", name, mean,
+                mean - margin, mean + margin);
+    } else {
+        fprintf(stderr, "  %-11s %.4g (95%% confidence upper bound %.4g, the probes vary too much\n"
+                "              for a lower bound)\n", name, mean, mean + margin);
+    }
+}
+
+void printDuration(double seconds){
+    if(seconds < 120){
+        fprintf(stderr, "%.1f seconds", seconds);
+    } else if(seconds < 2*3600){
+        fprintf(stderr, "%.1f minutes", seconds/60);
+    } else if(seconds < 2*86400){
+        fprintf(stderr, "%.1f hours", seconds/3600);
+    } else {
+        fprintf(stderr, "%.1f days", seconds/86400);
+    }
+}
+
+/* Estimates the size of the search tree for the current graph with random
+ * probes as in Knuth's method, instead of searching it. The number of nodes
+ * per second is measured during the probes.
+ */
+void estimateSearch(int probes){
+    int i;
+    double nodes = 0, nodeSquares = 0;
+    double leaves = 0, leafSquares = 0;
+    double embeddings = 0, embeddingSquares = 0;
+    int embeddingProbes = 0; /* the number of probes that reached an embedding */
+    struct timespec start, end;
+    
+    allocateGraphSearchState();
+    probing = TRUE;
+    probeSeed = 1;
+    probeSteps = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < probes; i++){
+        probeWeight = 1;
+        probeNodes = 1;
+        probeEmbeddings = 0;
+        probeSteps++;
+        startThrackling();
+        nodes += probeNodes;
+        nodeSquares += probeNodes * probeNodes;
+        //the probe ends in a leaf
+        leaves += probeWeight;
+        leafSquares += probeWeight * probeWeight;
+        embeddings += probeEmbeddings;
+        embeddingSquares += probeEmbeddings * probeEmbeddings;
+        if(probeEmbeddings > 0){
+            embeddingProbes++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    probing = FALSE;
+    freeGraphSearchState();
+    
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+    double nodesPerSecond = seconds > 0 ? probeSteps / seconds : 0;
+    fprintf(stderr, "Estimate of the search tree from %d random probe%s:\n",
+            probes, probes == 1 ? "" : "s");
+    printEstimate("nodes:", nodes, nodeSquares, probes);
+    printEstimate("leaves:", leaves, leafSquares, probes);
+    if(embeddingProbes > 0){
+        printEstimate("embeddings:", embeddings, embeddingSquares, probes);
+    } else {
+        //an interval of the probes would wrongly claim that there are none
+        fprintf(stderr, "  %-11s unknown, no probe reached an embedding\n", "embeddings:");
+        if(probes >= 3){
+            fprintf(stderr, "              (by the rule of three fewer than %.3g%% of the probes would\n"
+                    "              reach one, with 95%% confidence)\n", 300.0 / probes);
+        }
+    }
+    if(nodesPerSecond > 0){
+        fprintf(stderr, "At %.4g nodes per second the search takes about ", nodesPerSecond);
+        printDuration(nodes / probes / nodesPerSecond);
+        fprintf(stderr, ".\n");
+    }
+}
+
+/* Called instead of splitting when the search reaches the split level while
+ * sampling. The size of the subtree below the current node is estimated with
+ * random probes and added to the cost of the part that would search it. The
+ * search is stopped when the level has too many nodes.
+ */
+void sampleSplitNode(){
+    int i;
+    int level = splitLevel;
+    int restricted = choiceRestricted;
+    double size = 0;
+    
+    splitLevel = -1;
+    probing = TRUE;
+    for(i = 0; i < splitSampleProbes; i++){
+        probeWeight = 1;
+        probeNodes = 0;
+        probeEmbeddings = 0;
+        doNextEdge();
+        size += probeNodes;
+    }
+    probing = FALSE;
+    splitLevel = level;
+    choiceRestricted = restricted;
+    
+    splitPartCosts[splitlevelCounter % splitSampleParts] += size / splitSampleProbes;
+    splitlevelCounter++;
+    if(splitlevelCounter > AUTO_SPLIT_MAX_NODES){
+        stopSearch();
+    }
+}
+
+/* Selects the split level for the given number of parts. Random probes first
+ * estimate the number of nodes at each level and the number of nodes above it,
+ * which are searched by every part. Then the levels are tried from the top:
+ * the search up to the level is done completely, the subtree of each node at
+ * the level is sampled with random probes, and the nodes are assigned to the
+ * parts in the same way as with -m. The samples of single subtrees are too
+ * noisy to predict the size of a part, so they only give the share of each
+ * part in the nodes below the level. The shallowest level with at least one
+ * node per part for which the largest part is predicted to be at most
+ * AUTO_SPLIT_IMBALANCE times an even share of the search tree is selected, and
+ * otherwise the level with the smallest predicted largest part. The probes
+ * always start from the same seed, so all parts select the same level.
+ */
+int selectSplitLevel(int parts){
+    int i, level, best = -1;
+    int givenSplitLevel = splitLevel;
+    boolean givenIterativeSearch = iterativeSearch;
+    double total = 0, bestMaximum = 0;
+    double levelNodes[MAXE + 1], levelBelow[MAXE + 1];
+    boolean verbose = !batchMode;
+    
+    for(level = 0; level < edgeCount; level++){
+        levelNodes[level] = levelBelow[level] = 0;
+    }
+    
+    //the sampling continues the recursive search from the nodes at the level
+    iterativeSearch = FALSE;
+    selectSearch();
+    allocateGraphSearchState();
+    splitLevel = -1;
+    probing = TRUE;
+    probeSeed = 1;
+    for(i = 0; i < AUTO_SPLIT_PROBES; i++){
+        for(level = 0; level < edgeCount; level++){
+            probeLevelWeight[level] = 0;
+        }
+        probeWeight = 1;
+        probeNodes = 1;
+        probeEmbeddings = 0;
+        startThrackling();
+        total += probeNodes;
+        for(level = 2; level < edgeCount; level++){
+            if(probeLevelWeight[level] > 0){
+                //the sampled node stands for weight nodes at this level
+                levelNodes[level] += probeLevelWeight[level];
+                levelBelow[level] += probeNodes - probeLevelNodes[level];
+            }
+        }
+    }
+    probing = FALSE;
+    total /= AUTO_SPLIT_PROBES;
+    
+    splitSampleParts = parts;
+    splitPartCosts = malloc(sizeof(double) * parts);
+    if(splitPartCosts == NULL){
+        fprintf(stderr, "Insufficient memory for the split level -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    if(verbose){
+        fprintf(stderr, "Predicted number of nodes searched by each of %d parts:\n", parts);
+        fprintf(stderr, "  level  nodes at level      mean part   largest part\n");
+    }
+    for(level = 2; level < edgeCount; level++){
+        double nodes = levelNodes[level] / AUTO_SPLIT_PROBES;
+        if(nodes == 0){
+            continue;
+        } else if(nodes > AUTO_SPLIT_MAX_NODES){
+            break;
+        }
+        double below = levelBelow[level] / AUTO_SPLIT_PROBES;
+        double above = total - below;
+        
+        splitSampleProbes = nodes < AUTO_SPLIT_PROBES ? AUTO_SPLIT_PROBES / nodes : 1;
+        for(i = 0; i < parts; i++){
+            splitPartCosts[i] = 0;
+        }
+        splitLevel = level;
+        splitlevelCounter = 0;
+        splitNodeHandler = sampleSplitNode;
+        startThrackling();
+        splitNodeHandler = NULL;
+        if(splitlevelCounter > AUTO_SPLIT_MAX_NODES){
+            break;
+        }
+        
+        double sampled = 0, largestShare = 0;
+        for(i = 0; i < parts; i++){
+            sampled += splitPartCosts[i];
+            if(splitPartCosts[i] > largestShare){
+                largestShare = splitPartCosts[i];
+            }
+        }
+        double mean = above + below / parts;
+        double maximum = sampled > 0 ? above + below * largestShare / sampled : mean;
+        if(verbose){
+            fprintf(stderr, "  %5d  %14d  %13.4g  %13.4g\n", level, splitlevelCounter, mean, maximum);
+        }
+        if(splitlevelCounter >= parts && maximum <= AUTO_SPLIT_IMBALANCE * total / parts){
+            best = level;
+            break;
+        } else if(best == -1 || maximum < bestMaximum){
+            best = level;
+            bestMaximum = maximum;
+        }
+    }
+    free(splitPartCosts);
+    splitLevel = givenSplitLevel;
+    splitlevelCounter = 0;
+    freeGraphSearchState();
+    iterativeSearch = givenIterativeSearch;
+    selectSearch();
+    
+    return best;
+}
+
+/* Numbers the edges with each strategy and keeps the one for which the search
+ * tree is estimated to be the smallest.
+ */
+boolean selectEdgeOrder(GRAPH graph, ADJACENCY adj){
+    int strategy, best = 0;
+    double estimate, bestEstimate = 0;
+    boolean verbose = !batchMode && !censusMode;
+    
+    for(strategy = 0; strategy < EDGE_ORDER_COUNT; strategy++){
+        if(!orderEdgesWithStrategy(graph, adj, strategy)){
+            return FALSE;
+        }
+        estimate = estimateTreeSize(graph, adj, EDGE_ORDER_PROBES);
+        if(verbose){
+            fprintf(stderr, "Estimated size of search tree with edge order %s: %.4g\n",
+                    edgeOrderNames[strategy], estimate);
+        }
+        if(strategy == 0 || estimate < bestEstimate){
+            best = strategy;
+            bestEstimate = estimate;
+        }
+    }
+    if(verbose){
+        fprintf(stderr, "Using edge order %s.\n", edgeOrderNames[best]);
+    }
+    
+    return orderEdgesWithStrategy(graph, adj, best);
+}
+
+/**
+ * Stores the edges in the array numberedEdges using the selected strategy.
+ * Returns FALSE if the graph cannot be handled.
+ */
+boolean orderEdges(GRAPH graph, ADJACENCY adj){
+    if(edgeOrder == EDGE_ORDER_AUTO){
+        return selectEdgeOrder(graph, adj);
+    } else {
+        return orderEdgesWithStrategy(graph, adj, edgeOrder);
+    }
+}
+
+void printStartSummary(){
+    fprintf(stderr, "Input graph has %d %s and %d edge%s.\n",
+            nv, nv == 1 ? "vertex" : "vertices",
+            edgeCount, edgeCount==1 ? "" : "s");
+    fprintf(stderr, "A thrackle embedding for this graph will have %d intersection%s.\n",
+            intersectionCount, intersectionCount == 1 ? "" : "s");
+    if(useAutomorphisms){
+        fprintf(stderr, "The automorphism group of this graph has %d element%s.\n",
+                automorphismCount, automorphismCount == 1 ? "" : "s");
+    }
+    if(extendFileName != NULL){
+        fprintf(stderr, "The embeddings of the first %d edge%s are read from %s.\n",
+                extendedEdgeCount, extendedEdgeCount == 1 ? "" : "s", extendFileName);
+    }
+}
+
+/* Writes for each k the number of crossings of the k-th edge with earlier
+ * edges and with all edges, which is the same in every thrackle embedding, and
+ * the number of embeddings of the first k edges that were found.
+ */
+void printEdgeCounts(){
+    int i, j;
+    
+    fprintf(stderr, "  k   edge   crossings  crossings  embeddings of\n");
+    fprintf(stderr, "             (earlier)  (in total)  the first k edges\n");
+    for(i = 0; i < edgeCount; i++){
+        int earlier = 0, total = 0;
+        for(j = 0; j < edgeCount; j++){
+            if(numberedEdges[i][0] != numberedEdges[j][0] && numberedEdges[i][0] != numberedEdges[j][1] &&
+                    numberedEdges[i][1] != numberedEdges[j][0] && numberedEdges[i][1] != numberedEdges[j][1]){
+                total++;
+                if(j < i){
+                    earlier++;
+                }
+            }
+        }
+        fprintf(stderr, "%3d) %2d - %2d %9d %10d  ", i + 1, numberedEdges[i][0] + 1,
+                numberedEdges[i][1] + 1, earlier, total);
+        //the embeddings of a subgraph that is extended are not counted
+        if(i + 1 < extendedEdgeCount){
+            fprintf(stderr, "-\n");
+        } else if(i + 1 == extendedEdgeCount){
+            fprintf(stderr, "%llu\n", extendedThrackles);
+        } else {
+            fprintf(stderr, "%llu\n",
+                    i < 2 ? 1 : (i + 1 < edgeCount ? edgeEmbeddings[i + 1] : numberOfThrackles));
+        }
+    }
+}
+
+void printEndSummary(){
+    if(testCommonPart){
+        fprintf(stderr, "Reached splitlevel %d time%s.\n", splitlevelCounter, splitlevelCounter == 1 ? "" : "s");
+    } else if(countOnly){
+        if(extendFileName != NULL){
+            fprintf(stderr, "Extended %llu thrackle embedding%s of the first %d edge%s.\n",
+                    extendedThrackles, extendedThrackles == 1 ? "" : "s",
+                    extendedEdgeCount, extendedEdgeCount == 1 ? "" : "s");
+        }
+        fprintf(stderr, "Found %llu thrackle embedding%s.\n",
+                numberOfThrackles, numberOfThrackles == 1 ? "" : "s");
+        if(breakSymmetry && reportLabelledCount && !justOne){
+            fprintf(stderr, "This corresponds to %llu labelled thrackle embedding%s.\n",
+                    labelledNumberOfThrackles, labelledNumberOfThrackles == 1 ? "" : "s");
+        }
+        if(nonIsomorphic){
+            fprintf(stderr, "Found %llu non-isomorphic thrackle embedding%s.\n",
+                    isomorphismClassCount, isomorphismClassCount == 1 ? "" : "s");
+        }
+        if(deduplicateSplitStates){
+            fprintf(stderr, "Searched the subtrees of %llu of the %llu states at the split level.\n",
+                    splitStatesSearched, splitStatesSearched + splitStatesSkipped);
+        }
+        printEdgeCounts();
+    } else {
+        if(extendFileName != NULL){
+            fprintf(stderr, "Extended %llu thrackle embedding%s of the first %d edge%s.\n",
+                    extendedThrackles, extendedThrackles == 1 ? "" : "s",
+                    extendedEdgeCount, extendedEdgeCount == 1 ? "" : "s");
+        }
+        fprintf(stderr, "%s %llu thrackle embedding%s.\n", nonIsomorphic ? "Found" : "Written",
+                numberOfThrackles, numberOfThrackles == 1 ? "" : "s");
+        if(breakSymmetry && reportLabelledCount && !justOne){
+            fprintf(stderr, "This corresponds to %llu labelled thrackle embedding%s.\n",
+                    labelledNumberOfThrackles, labelledNumberOfThrackles == 1 ? "" : "s");
+        }
+        if(nonIsomorphic){
+            fprintf(stderr, "Written %llu non-isomorphic thrackle embedding%s.\n",
+                    isomorphismClassCount, isomorphismClassCount == 1 ? "" : "s");
+        }
+    }
+}
+
+//=============== Writing thrackle_code of graph ===========================
+
+/* The codes are encoded directly into the output buffer. Every half-edge of the
+ * cross graph is written once, so a code has 2 + nv + ni + crossGraphEdgeCounter
+ * entries.
+ */
+void writeThrackleCodeChar(){
+    int i;
+    EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(thrackleOutput, 2 + nv + ni + crossGraphEdgeCounter);
+    
+    //write the number of vertices
+    code = putCodeByte(code, nv);
+    //write the number of intersections
+    code = putCodeByte(code, ni);
+    
+    for(i=0; i<nv + ni; i++){
+        e = elast = firstedge[i];
+        do {
+            code = putCodeByte(code, e->end + 1);
+            e = e->next;
+        } while (e != elast);
+        code = putCodeByte(code, 0);
+    }
+    finishCodeRecord(thrackleOutput, code);
+}
+
+void writeThrackleCodeShort(){
+    int i;
+    EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(thrackleOutput,
+            1 + 2*(2 + nv + ni + crossGraphEdgeCounter));
+    
+    code = putCodeByte(code, 0);
+    //write the number of vertices
+    code = putCodeShort(code, nv);
+    //write the number of intersections
+    code = putCodeShort(code, ni);
+    
+    
+    for(i=0; i<nv+ni; i++){
+        e = elast = firstedge[i];
+        do {
+            code = putCodeShort(code, e->end + 1);
+            e = e->next;
+        } while (e != elast);
+        code = putCodeShort(code, 0);
+    }
+    finishCodeRecord(thrackleOutput, code);
+}
+
+void writeThrackleCode(){
+    if(!thrackleCodeHeaderWritten){
+        thrackleCodeHeaderWritten = TRUE;
+        
+        appendCodeOutput(thrackleOutput, ">>thrackle_code<<", 17);
+        outputOffset += 17;
+    }
+    
+    //every half-edge of the cross graph is written once
+    if (nv + ni + 1 <= 255) {
+        writeThrackleCodeChar();
+        outputOffset += 2 + nv + ni + crossGraphEdgeCounter;
+    } else if (nv + ni + 1 <= 65535) {
+        writeThrackleCodeShort();
+        outputOffset += 1 + 2*(2 + nv + ni + crossGraphEdgeCounter);
+    } else {
+        fprintf(stderr, "Graphs of that size are currently not supported -- exiting!\n");
+        exit(-1);
+    }
+    
+}
+
+/* Writes the output that is still buffered when the program exits.
+ */
+void closeStandardOutput(){
+    closeCodeOutput(&standardOutput);
+}
+
+//=============== Checkpoints ===========================
+
+#define GRAPH_DESCRIPTION_SIZE (32 + 8*MAXE)
+
+/* Writes the number of vertices and edges and the edges in the order in which
+ * they are added to description, so that another process can check that it
+ * searches the same graph.
+ */
+void describeGraph(char *description){
+    int i;
+    int length = sprintf(description, "graph %d %d", nv, edgeCount);
+    
+    for(i = 0; i < edgeCount; i++){
+        length += sprintf(description + length, " %d-%d",
+                numberedEdges[i][0] + 1, numberedEdges[i][1] + 1);
+    }
+}
+
+/* Writes the state of the search to the checkpoint file. This is called at a
+ * choice point, just before the search continues with the alternative in
+ * choicePath. The file is replaced atomically, so a crash while writing leaves
+ * the previous checkpoint intact.
+ */
+void writeCheckpoint(boolean finished){
+    int i;
+    char temporaryName[strlen(checkpointFileName) + 5];
+    char description[GRAPH_DESCRIPTION_SIZE];
+    
+    checkpointRequested = FALSE;
+    
+    //the output up to the offset should be on disk before the checkpoint
+    flushCodeOutput(thrackleOutput);
+    fsync(thrackleOutput->fd);
+    
+    sprintf(temporaryName, "%s.tmp", checkpointFileName);
+    FILE *checkpoint = fopen(temporaryName, "w");
+    if(checkpoint == NULL){
+        fprintf(stderr, "Could not write checkpoint to %s.\n", temporaryName);
+    } else {
+        describeGraph(description);
+        fprintf(checkpoint, "thrackler checkpoint\n");
+        fprintf(checkpoint, "%s", description);
+        fprintf(checkpoint, "\noptions %d %d %d %d %d %d\n", breakGraphSymmetry,
+                breakMirrorSymmetry, splittingEnabled, splitLevel, currentPart, totalParts);
+        fprintf(checkpoint, "thrackles %llu %llu\n", numberOfThrackles, labelledNumberOfThrackles);
+        //the split level on the current path is reached again when resuming
+        fprintf(checkpoint, "splitlevel %d\n", splitLevel >= 2 && edgeCounter > splitLevel ?
+                splitlevelCounter - 1 : splitlevelCounter);
+        //the nodes on the current path are counted again when resuming
+        fprintf(checkpoint, "partial");
+        for(i = 0; i < edgeCount; i++){
+            fprintf(checkpoint, " %llu", i >= 2 && i < edgeCounter ?
+                    edgeEmbeddings[i] - 1 : edgeEmbeddings[i]);
+        }
+        fprintf(checkpoint, "\noffset %llu\n", outputOffset);
+        if(finished){
+            fprintf(checkpoint, "finished\n");
+        } else {
+            fprintf(checkpoint, "path %d", choiceDepth);
+            for(i = 0; i < choiceDepth; i++){
+                fprintf(checkpoint, " %d", choicePath[i]);
+            }
+            fprintf(checkpoint, "\n");
+        }
+        if(fclose(checkpoint) || rename(temporaryName, checkpointFileName)){
+            fprintf(stderr, "Could not write checkpoint to %s.\n", checkpointFileName);
+        }
+    }
+}
+
+void invalidCheckpoint(){
+    fprintf(stderr, "The checkpoint in %s does not belong to this graph and these options -- exiting!\n",
+            resumeFileName);
+    exit(EXIT_FAILURE);
+}
+
+/* Restores the state of the search from the checkpoint in resumeFileName, so
+ * that the search continues where the checkpoint was written. Returns FALSE if
+ * the search had already finished.
+ */
+boolean resumeSearch(){
+    int i, value[6], from, to, depth;
+    char state[10];
+    
+    FILE *checkpoint = fopen(resumeFileName, "r");
+    if(checkpoint == NULL){
+        fprintf(stderr, "Could not read checkpoint from %s -- exiting!\n", resumeFileName);
+        exit(EXIT_FAILURE);
+    }
+    if(fscanf(checkpoint, " thrackler checkpoint graph %d %d", value, value + 1) != 2 ||
+            value[0] != nv || value[1] != edgeCount){
+        invalidCheckpoint();
+    }
+    for(i = 0; i < edgeCount; i++){
+        if(fscanf(checkpoint, " %d-%d", &from, &to) != 2 ||
+                from != numberedEdges[i][0] + 1 || to != numberedEdges[i][1] + 1){
+            invalidCheckpoint();
+        }
+    }
+    if(fscanf(checkpoint, " options %d %d %d %d %d %d", value, value + 1, value + 2,
+            value + 3, value + 4, value + 5) != 6 ||
+            value[0] != breakGraphSymmetry || value[1] != breakMirrorSymmetry ||
+            value[2] != splittingEnabled || value[3] != splitLevel ||
+            value[4] != currentPart || value[5] != totalParts){
+        invalidCheckpoint();
+    }
+    if(fscanf(checkpoint, " thrackles %llu %llu splitlevel %d partial",
+            &numberOfThrackles, &labelledNumberOfThrackles, &splitlevelCounter) != 3){
+        invalidCheckpoint();
+    }
+    for(i = 0; i < edgeCount; i++){
+        if(fscanf(checkpoint, "%llu", edgeEmbeddings + i) != 1){
+            invalidCheckpoint();
+        }
+    }
+    if(fscanf(checkpoint, " offset %llu %9s", &outputOffset, state) != 2){
+        invalidCheckpoint();
+    }
+    
+    //continue the output after the last embedding before the checkpoint
+    struct stat outputStatus;
+    thrackleCodeHeaderWritten = outputOffset > 0;
+    if(fstat(thrackleOutput->fd, &outputStatus) == 0 && S_ISREG(outputStatus.st_mode)){
+        if(outputStatus.st_size < outputOffset){
+            fprintf(stderr, "The output file is shorter than the %llu bytes that were written before the checkpoint.\n",
+                    outputOffset);
+            fprintf(stderr, "The output should be appended to the original output -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        if(ftruncate(thrackleOutput->fd, outputOffset) ||
+                lseek(thrackleOutput->fd, outputOffset, SEEK_SET) < 0){
+            fprintf(stderr, "Could not truncate the output file -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    } else if(outputOffset > 0){
+        fprintf(stderr, "The output continues after the first %llu bytes of the original output.\n",
+                outputOffset);
+    }
+    
+    if(strcmp(state, "finished") == 0){
+        fclose(checkpoint);
+        return FALSE;
+    }
+    if(strcmp(state, "path") != 0 || fscanf(checkpoint, "%d", &depth) != 1 ||
+            depth < 0 || depth > edgeCount + intersectionCount){
+        invalidCheckpoint();
+    }
+    for(i = 0; i < depth; i++){
+        if(fscanf(checkpoint, "%d", choiceFirst + i) != 1){
+            invalidCheckpoint();
+        }
+    }
+    choiceRestricted = depth - 1;
+    fclose(checkpoint);
+    return TRUE;
+}
+
+//=============== Progress reports ===========================
+
+void timerTick(int signalNumber){
+    secondsElapsed++;
+    if(checkpointFileName != NULL && secondsElapsed % checkpointInterval == 0){
+        checkpointRequested = TRUE;
+        workRequested = TRUE;
+    }
+    if(progressInterval > 0 && secondsElapsed % progressInterval == 0){
+        progressRequested = TRUE;
+        workRequested = TRUE;
+    }
+    if(workerAddress != NULL && secondsElapsed % heartbeatInterval == 0){
+        heartbeatRequested = TRUE;
+        workRequested = TRUE;
+    }
+}
+
+void requestProgress(int signalNumber){
+    progressRequested = TRUE;
+    workRequested = TRUE;
+}
+
+/* Starts the timer for the checkpoints and the progress reports and enables
+ * the progress report on SIGUSR1.
+ */
+void startTimer(){
+    struct sigaction action;
+    struct itimerval timer = {{1, 0}, {1, 0}};
+    
+    clock_gettime(CLOCK_MONOTONIC, &progressStart);
+    lastProgressSeconds = 0;
+    lastProgressNodes = 0;
+    secondsElapsed = 0;
+    
+    //interrupted writes are restarted
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = requestProgress;
+    sigaction(SIGUSR1, &action, NULL);
+    if(checkpointFileName != NULL || progressInterval > 0 || workerAddress != NULL){
+        action.sa_handler = timerTick;
+        sigaction(SIGALRM, &action, NULL);
+        setitimer(ITIMER_REAL, &timer, NULL);
+    }
+}
+
+void stopTimer(){
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    
+    if(checkpointFileName != NULL || progressInterval > 0 || workerAddress != NULL){
+        setitimer(ITIMER_REAL, &timer, NULL);
+    }
+    searcherCount = 0;
+}
+
+/* Writes the number of nodes visited so far for each edge and in total, the
+ * number of embeddings found and the speed since the previous report. In a
+ * single thread also the current depth and an estimate of the finished part
+ * of the search tree are written. This estimate assumes that all subtrees
+ * below the first PROGRESS_DEPTH choice points have the same size.
+ */
+void printProgress(){
+    int i, j;
+    unsigned long long int nodes[MAXE];
+    unsigned long long int totalNodes = 0, embeddings = 0;
+    struct timespec now;
+    FILE *output = progressFileName == NULL ? stderr : progressOutput;
+    
+    for(i = 0; i < edgeCount; i++){
+        nodes[i] = 0;
+        for(j = 0; j < searcherCount; j++){
+            nodes[i] += searcherNodes[j][i];
+        }
+        totalNodes += nodes[i];
+    }
+    for(j = 0; j < searcherCount; j++){
+        embeddings += *(searcherThrackles[j]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double seconds = (now.tv_sec - progressStart.tv_sec) + (now.tv_nsec - progressStart.tv_nsec)/1e9;
+    double speed = seconds > lastProgressSeconds ?
+        (totalNodes - lastProgressNodes) / (seconds - lastProgressSeconds) : 0;
+    lastProgressSeconds = seconds;
+    lastProgressNodes = totalNodes;
+    
+    fprintf(output, "Progress after %.1fs: %llu nodes (%.4g per second), %llu embedding%s",
+            seconds, totalNodes, speed, embeddings, embeddings == 1 ? "" : "s");
+    if(threadCount == 1){
+        double finished = 0, weight = 1;
+        for(i = 0; i < choiceDepth && i < PROGRESS_DEPTH; i++){
+            finished += weight * choicePath[i] / choiceSize[i];
+            weight /= choiceSize[i];
+        }
+        fprintf(output, ", %.2f%% finished, at edge %d of %d and depth %d",
+                100*finished, edgeCounter, edgeCount, choiceDepth);
+    }
+    fprintf(output, "\n  nodes per edge:");
+    for(i = 0; i < edgeCount; i++){
+        if(nodes[i]){
+            fprintf(output, " %d:%llu", i + 1, nodes[i]);
+        }
+    }
+    fprintf(output, "\n");
+    fflush(output);
+}
+
+//=============== Distributed search ===========================
+
+/* Opens a socket for the address, which is host:port for TCP and otherwise the
+ * path of a Unix domain socket. The coordinator listens on the socket and a
+ * worker connects to it. Returns -1 if this fails.
+ */
+int openSocket(char *address, boolean listening){
+    int fd = -1;
+    char *port = strrchr(address, ':');
+    
+    if(port == NULL){
+        struct sockaddr_un unixAddress;
+        if(strlen(address) >= sizeof(unixAddress.sun_path)){
+            return -1;
+        }
+        memset(&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        strcpy(unixAddress.sun_path, address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0){
+            return -1;
+        }
+        if(listening){
+            //a socket left behind by an earlier coordinator is replaced
+            unlink(address);
+            if(bind(fd, (struct sockaddr *)&unixAddress, sizeof(unixAddress)) ||
+                    listen(fd, SOMAXCONN)){
+                close(fd);
+                return -1;
+            }
+        } else if(connect(fd, (struct sockaddr *)&unixAddress, sizeof(unixAddress))){
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    
+    char host[port - address + 1];
+    struct addrinfo hints, *addresses, *a;
+    memcpy(host, address, port - address);
+    host[port - address] = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    if(getaddrinfo(host[0] ? host : NULL, port + 1, &hints, &addresses)){
+        return -1;
+    }
+    for(a = addresses; a != NULL && fd < 0; a = a->ai_next){
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if(fd < 0){
+            continue;
+        }
+        if(listening){
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if(bind(fd, a->ai_addr, a->ai_addrlen) || listen(fd, SOMAXCONN)){
+                close(fd);
+                fd = -1;
+            }
+        } else if(connect(fd, a->ai_addr, a->ai_addrlen)){
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+/* Reads one line from the connection into line, without the newline. Returns
+ * FALSE if the connection is closed or times out before the end of the line.
+ */
+boolean readLine(int fd, char *line){
+    int length = 0;
+    
+    while(length < MESSAGE_SIZE - 1){
+        ssize_t count = recv(fd, line + length, MESSAGE_SIZE - 1 - length, 0);
+        if(count < 0 && errno == EINTR){
+            continue;
+        } else if(count <= 0){
+            return FALSE;
+        }
+        char *end = memchr(line + length, '\n', count);
+        length += count;
+        if(end != NULL){
+            *end = '\0';
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Writes the line followed by a newline to the connection.
+ */
+boolean writeLine(int fd, char *line){
+    size_t length = strlen(line);
+    size_t written = 0;
+    
+    line[length] = '\n';
+    while(written <= length){
+        ssize_t count = send(fd, line + written, length + 1 - written, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR){
+            continue;
+        } else if(count <= 0){
+            break;
+        }
+        written += count;
+    }
+    line[length] = '\0';
+    return written > length;
+}
+
+void setMessageTimeout(int fd){
+    struct timeval timeout = {MESSAGE_TIMEOUT, 0};
+    
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+/* Sends the message in messageBuffer to the coordinator and stores its answer
+ * in replyBuffer. Returns FALSE if the coordinator could not be reached.
+ */
+boolean sendMessage(){
+    int fd = openSocket(workerAddress, FALSE);
+    
+    if(fd < 0){
+        return FALSE;
+    }
+    setMessageTimeout(fd);
+    boolean answered = writeLine(fd, messageBuffer) && readLine(fd, replyBuffer);
+    close(fd);
+    return answered;
+}
+
+/* Writes the line with which a worker introduces itself to description. The
+ * coordinator only hands out units to workers with the same line.
+ */
+void describeWorker(char *description){
+    int length = sprintf(description, "hello ");
+    
+    describeGraph(description + length);
+    length += strlen(description + length);
+    sprintf(description + length, " options %d %d %d",
+            breakGraphSymmetry, breakMirrorSymmetry, countOnly);
+}
+
+void allocateMessageBuffers(){
+    messageBuffer = malloc(MESSAGE_SIZE);
+    replyBuffer = malloc(MESSAGE_SIZE);
+    if(messageBuffer == NULL || replyBuffer == NULL){
+        fprintf(stderr, "Insufficient memory for messages -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void freeMessageBuffers(){
+    free(messageBuffer);
+    free(replyBuffer);
+}
+
+void getUnitFileName(char *name, int unit, int attempt){
+    sprintf(name, "%s/unit-%d-%d", unitDirectory, unit, attempt);
+}
+
+/* Called at the split level while the coordinator enumerates the work units.
+ */
+void recordWorkUnit(){
+    if(workUnitCount == workUnitCapacity){
+        workUnitCapacity = workUnitCapacity == 0 ? 1024 : 2*workUnitCapacity;
+        workUnits = realloc(workUnits, sizeof(WORKUNIT) * workUnitCapacity);
+        if(workUnits == NULL){
+            fprintf(stderr, "Insufficient memory for the work units -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    WORKUNIT *unit = workUnits + workUnitCount++;
+    unit->depth = choiceDepth;
+    unit->path = malloc(sizeof(int) * (choiceDepth + 1));
+    if(unit->path == NULL){
+        fprintf(stderr, "Insufficient memory for the work units -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(unit->path, choicePath, sizeof(int) * choiceDepth);
+    unit->state = UNIT_PENDING;
+    unit->attempt = 0;
+    unit->acceptedAttempt = 0;
+}
+
+/* Hands the units that nothing was heard of for unitTimeout seconds out again.
+ */
+void reassignWorkUnits(time_t now){
+    int i;
+    
+    for(i = 0; i < nextWorkUnit; i++){
+        if(workUnits[i].state == UNIT_RUNNING && now - workUnits[i].lastHeard > unitTimeout){
+            fprintf(stderr, "Unit %d was not reported on for %d seconds and will be handed out again.\n",
+                    i, unitTimeout);
+            workUnits[i].state = UNIT_PENDING;
+            reassignedWorkUnits++;
+        }
+    }
+}
+
+/* Returns the next unit to hand out, or -1 if there is none.
+ */
+int takeWorkUnit(){
+    int i;
+    
+    if(reassignedWorkUnits > 0){
+        for(i = 0; i < nextWorkUnit; i++){
+            if(workUnits[i].state == UNIT_PENDING){
+                reassignedWorkUnits--;
+                return i;
+            }
+        }
+    }
+    if(nextWorkUnit < workUnitCount){
+        return nextWorkUnit++;
+    }
+    return -1;
+}
+
+/* Stores the result of a unit, which is written as
+ * result unit attempt thrackles labelled edgeEmbeddings...
+ * Only the first result of each unit is kept and the output of the others is
+ * removed.
+ */
+void storeWorkUnitResult(char *result){
+    int i, unit, attempt;
+    unsigned long long int thrackles, labelled, embeddings[MAXE];
+    char *position;
+    char name[strlen(unitDirectory) + 32];
+    
+    unit = strtol(result, &position, 10);
+    attempt = strtol(position, &position, 10);
+    thrackles = strtoull(position, &position, 10);
+    labelled = strtoull(position, &position, 10);
+    for(i = 0; i < edgeCount; i++){
+        embeddings[i] = strtoull(position, &position, 10);
+    }
+    if(unit < 0 || unit >= nextWorkUnit || attempt < 1 || attempt > workUnits[unit].attempt){
+        return;
+    }
+    if(workUnits[unit].state == UNIT_FINISHED){
+        if(attempt != workUnits[unit].acceptedAttempt && !countOnly){
+            getUnitFileName(name, unit, attempt);
+            unlink(name);
+        }
+        return;
+    }
+    if(workUnits[unit].state == UNIT_PENDING){
+        reassignedWorkUnits--;
+    }
+    workUnits[unit].state = UNIT_FINISHED;
+    workUnits[unit].acceptedAttempt = attempt;
+    finishedWorkUnits++;
+    numberOfThrackles += thrackles;
+    labelledNumberOfThrackles += labelled;
+    for(i = 0; i < edgeCount; i++){
+        edgeEmbeddings[i] += embeddings[i];
+    }
+}
+
+/* Answers the message from a worker in messageBuffer in replyBuffer.
+ */
+void answerWorker(char *description){
+    int i, unit, attempt;
+    
+    if(strncmp(messageBuffer, "hello ", 6) == 0){
+        if(strcmp(messageBuffer, description) == 0){
+            sprintf(replyBuffer, "ok %d", unitTimeout);
+        } else {
+            sprintf(replyBuffer, "error");
+        }
+    } else if(strcmp(messageBuffer, "request") == 0){
+        unit = takeWorkUnit();
+        if(unit >= 0){
+            WORKUNIT *workUnit = workUnits + unit;
+            workUnit->state = UNIT_RUNNING;
+            workUnit->attempt++;
+            workUnit->lastHeard = time(NULL);
+            int length = sprintf(replyBuffer, "unit %d %d %d", unit, workUnit->attempt, workUnit->depth);
+            for(i = 0; i < workUnit->depth; i++){
+                length += sprintf(replyBuffer + length, " %d", workUnit->path[i]);
+            }
+            replyBuffer[length++] = ' ';
+            getUnitFileName(replyBuffer + length, unit, workUnit->attempt);
+        } else if(finishedWorkUnits == workUnitCount){
+            sprintf(replyBuffer, "done");
+        } else {
+            //the remaining units may still be handed out again
+            sprintf(replyBuffer, "wait 1");
+        }
+    } else if(sscanf(messageBuffer, "alive %d %d", &unit, &attempt) == 2){
+        if(unit >= 0 && unit < nextWorkUnit && attempt == workUnits[unit].attempt &&
+                workUnits[unit].state != UNIT_FINISHED){
+            if(workUnits[unit].state == UNIT_PENDING){
+                //the unit was not handed out again yet
+                workUnits[unit].state = UNIT_RUNNING;
+                reassignedWorkUnits--;
+            }
+            workUnits[unit].lastHeard = time(NULL);
+            sprintf(replyBuffer, "ok");
+        } else {
+            sprintf(replyBuffer, "cancel");
+        }
+    } else if(strncmp(messageBuffer, "result ", 7) == 0){
+        storeWorkUnitResult(messageBuffer + 7);
+        sprintf(replyBuffer, "ok");
+    } else {
+        sprintf(replyBuffer, "error");
+    }
+}
+
+/* Waits at most a second for a message from a worker and answers it.
+ */
+void serveWorker(int listener, char *description){
+    struct pollfd request = {listener, POLLIN, 0};
+    
+    if(poll(&request, 1, 1000) <= 0){
+        return;
+    }
+    int fd = accept(listener, NULL, NULL);
+    if(fd < 0){
+        return;
+    }
+    setMessageTimeout(fd);
+    if(readLine(fd, messageBuffer)){
+        answerWorker(description);
+        writeLine(fd, replyBuffer);
+    }
+    close(fd);
+}
+
+/* Writes the output of the units in the order of the search and removes their
+ * files.
+ */
+void writeWorkUnitOutput(){
+    int i;
+    ssize_t count;
+    struct stat status;
+    char name[strlen(unitDirectory) + 32];
+    char *buffer = malloc(outputBlockSize);
+    
+    if(buffer == NULL){
+        fprintf(stderr, "Insufficient memory for the output -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < workUnitCount; i++){
+        getUnitFileName(name, i, workUnits[i].acceptedAttempt);
+        int fd = open(name, O_RDONLY);
+        if(fd < 0 || fstat(fd, &status)){
+            fprintf(stderr, "Could not read the output of unit %d from %s -- exiting!\n", i, name);
+            exit(EXIT_FAILURE);
+        }
+        //each file starts with its own header
+        if(status.st_size > 17){
+            if(!thrackleCodeHeaderWritten){
+                thrackleCodeHeaderWritten = TRUE;
+                appendCodeOutput(thrackleOutput, ">>thrackle_code<<", 17);
+            }
+            lseek(fd, 17, SEEK_SET);
+            while((count = read(fd, buffer, outputBlockSize)) > 0){
+                appendCodeOutput(thrackleOutput, buffer, count);
+            }
+        }
+        close(fd);
+        unlink(name);
+    }
+    free(buffer);
+}
+
+/* Removes the files that were left behind by workers of which the results were
+ * not kept.
+ */
+void removeWorkUnitFiles(){
+    int i, attempt;
+    char name[strlen(unitDirectory) + 32];
+    
+    for(i = 0; i < workUnitCount; i++){
+        for(attempt = 1; attempt <= workUnits[i].attempt; attempt++){
+            getUnitFileName(name, i, attempt);
+            if(attempt != workUnits[i].acceptedAttempt && !countOnly){
+                unlink(name);
+            }
+            strcat(name, ".tmp");
+            unlink(name);
+        }
+        free(workUnits[i].path);
+    }
+    free(workUnits);
+    workUnits = NULL;
+    workUnitCount = workUnitCapacity = 0;
+}
+
+/* Searches up to the split level, hands the subtrees below it out to workers
+ * and combines their results.
+ */
+void coordinateSearch(){
+    char description[GRAPH_DESCRIPTION_SIZE + 64];
+    char *directory = realpath(unitDirectory, NULL);
+    time_t now, lastCheck = 0;
+    
+    //the workers get the absolute names of the files
+    if(directory == NULL){
+        fprintf(stderr, "The unit directory %s does not exist -- exiting!\n", unitDirectory);
+        exit(EXIT_FAILURE);
+    }
+    unitDirectory = directory;
+    
+    allocateGraphSearchState();
+    splitNodeHandler = recordWorkUnit;
+    startThrackling();
+    splitNodeHandler = NULL;
+    freeGraphSearchState();
+    nextWorkUnit = reassignedWorkUnits = finishedWorkUnits = 0;
+    
+    int listener = openSocket(coordinatorAddress, TRUE);
+    if(listener < 0){
+        fprintf(stderr, "Could not listen on %s -- exiting!\n", coordinatorAddress);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "Handing out %d unit%s on %s.\n", workUnitCount,
+            workUnitCount == 1 ? "" : "s", coordinatorAddress);
+    
+    allocateMessageBuffers();
+    describeWorker(description);
+    while(finishedWorkUnits < workUnitCount){
+        now = time(NULL);
+        if(now != lastCheck){
+            reassignWorkUnits(now);
+            lastCheck = now;
+        }
+        serveWorker(listener, description);
+    }
+    if(!countOnly){
+        writeWorkUnitOutput();
+    }
+    
+    //the workers that wait for a unit are told that the search is finished
+    now = time(NULL);
+    while(time(NULL) - now < FINISH_GRACE_PERIOD){
+        serveWorker(listener, description);
+    }
+    close(listener);
+    if(strchr(coordinatorAddress, ':') == NULL){
+        unlink(coordinatorAddress);
+    }
+    freeMessageBuffers();
+    removeWorkUnitFiles();
+    free(directory);
+    unitDirectory = NULL;
+}
+
+/* Called at a choice point when it is time to tell the coordinator that the
+ * worker is still searching its unit.
+ */
+void sendHeartbeat(){
+    heartbeatRequested = FALSE;
+    sprintf(messageBuffer, "alive %d %d", currentUnit, currentAttempt);
+    if(sendMessage() && strcmp(replyBuffer, "cancel") == 0){
+        unitCancelled = TRUE;
+        workRequested = TRUE;
+    }
+}
+
+/* Searches the unit of which the path is in choiceFirst and choiceLast and
+ * writes its embeddings to the file with the given name.
+ */
+void searchWorkUnit(int depth, char *name){
+    int i;
+    int fd = -1;
+    char temporaryName[strlen(name) + 5];
+    CODEOUTPUT unitOutput;
+    
+    numberOfThrackles = 0;
+    labelledNumberOfThrackles = 0;
+    for(i = 0; i < edgeCount; i++){
+        edgeEmbeddings[i] = 0;
+    }
+    unitCancelled = FALSE;
+    
+    //the file only gets its name when the unit is finished
+    sprintf(temporaryName, "%s.tmp", name);
+    if(!countOnly){
+        fd = open(temporaryName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0){
+            fprintf(stderr, "Could not write the output of unit %d to %s -- exiting!\n",
+                    currentUnit, temporaryName);
+            exit(EXIT_FAILURE);
+        }
+        openCodeOutput(&unitOutput, fd, outputBlockSize);
+        thrackleOutput = &unitOutput;
+        thrackleCodeHeaderWritten = FALSE;
+    }
+    
+    choiceRestricted = depth - 1;
+    countFromDepth = depth;
+    searcherCount = 1;
+    startTimer();
+    startThrackling();
+    stopTimer();
+    for(i = 0; i < depth; i++){
+        choiceFirst[i] = 0;
+        choiceLast[i] = INT_MAX;
+    }
+    choiceRestricted = -1;
+    countFromDepth = 0;
+    
+    if(!countOnly){
+        closeCodeOutput(&unitOutput);
+        thrackleOutput = &standardOutput;
+        if(close(fd) || (!unitCancelled && rename(temporaryName, name))){
+            fprintf(stderr, "Could not write the output of unit %d to %s -- exiting!\n",
+                    currentUnit, name);
+            exit(EXIT_FAILURE);
+        }
+        if(unitCancelled){
+            unlink(temporaryName);
+        }
+    }
+}
+
+/* Reads the unit in replyBuffer, which is written as
+ * unit number attempt depth path... file
+ * Returns the depth, or -1 if the reply is not a unit.
+ */
+int readWorkUnit(char **name){
+    int i, depth;
+    char *position;
+    
+    if(strncmp(replyBuffer, "unit ", 5) != 0){
+        return -1;
+    }
+    currentUnit = strtol(replyBuffer + 5, &position, 10);
+    currentAttempt = strtol(position, &position, 10);
+    depth = strtol(position, &position, 10);
+    if(depth < 0 || depth > edgeCount + intersectionCount){
+        return -1;
+    }
+    for(i = 0; i < depth; i++){
+        choiceFirst[i] = choiceLast[i] = strtol(position, &position, 10);
+    }
+    if(*position != ' '){
+        return -1;
+    }
+    *name = position + 1;
+    return depth;
+}
+
+/* Asks the coordinator for units until the search is finished, and searches
+ * them.
+ */
+void workForCoordinator(){
+    int i, depth, seconds;
+    int units = 0;
+    unsigned long long int thrackles = 0, labelled = 0;
+    char *name;
+    
+    allocateMessageBuffers();
+    describeWorker(messageBuffer);
+    for(i = 1; !sendMessage(); i++){
+        if(i == CONNECT_ATTEMPTS){
+            fprintf(stderr, "Could not reach the coordinator at %s -- exiting!\n", workerAddress);
+            exit(EXIT_FAILURE);
+        }
+        sleep(1);
+    }
+    if(sscanf(replyBuffer, "ok %d", &seconds) != 1){
+        fprintf(stderr, "The coordinator at %s searches another graph or uses other options -- exiting!\n",
+                workerAddress);
+        exit(EXIT_FAILURE);
+    }
+    heartbeatInterval = seconds / 3 > 1 ? seconds / 3 : 1;
+    
+    allocateGraphSearchState();
+    for(i = 0; i < edgeCount; i++){
+        edgeNodes[i] = 0;
+    }
+    searcherNodes[0] = edgeNodes;
+    searcherThrackles[0] = &numberOfThrackles;
+    splitLevel = -1;
+    while(TRUE){
+        sprintf(messageBuffer, "request");
+        if(!sendMessage()){
+            fprintf(stderr, "The coordinator at %s cannot be reached anymore.\n", workerAddress);
+            break;
+        } else if(strcmp(replyBuffer, "done") == 0){
+            break;
+        } else if(sscanf(replyBuffer, "wait %d", &seconds) == 1){
+            sleep(seconds);
+            continue;
+        }
+        depth = readWorkUnit(&name);
+        if(depth < 0){
+            fprintf(stderr, "Invalid reply from the coordinator at %s -- exiting!\n", workerAddress);
+            exit(EXIT_FAILURE);
+        }
+        //the reply buffer is reused by the heartbeats
+        name = strdup(name);
+        if(name == NULL){
+            fprintf(stderr, "Insufficient memory for the work unit -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        
+        searchWorkUnit(depth, name);
+        if(unitCancelled){
+            free(name);
+            continue;
+        }
+        
+        int length = sprintf(messageBuffer, "result %d %d %llu %llu", currentUnit,
+                currentAttempt, numberOfThrackles, labelledNumberOfThrackles);
+        for(i = 0; i < edgeCount; i++){
+            length += sprintf(messageBuffer + length, " %llu", edgeEmbeddings[i]);
+        }
+        if(!sendMessage()){
+            fprintf(stderr, "The result of unit %d could not be sent to the coordinator at %s.\n",
+                    currentUnit, workerAddress);
+            if(!countOnly){
+                unlink(name);
+            }
+            free(name);
+            break;
+        }
+        free(name);
+        units++;
+        thrackles += numberOfThrackles;
+        labelled += labelledNumberOfThrackles;
+    }
+    freeGraphSearchState();
+    freeMessageBuffers();
+    
+    fprintf(stderr, "Searched %d unit%s with %llu thrackle embedding%s.\n",
+            units, units == 1 ? "" : "s", thrackles, thrackles == 1 ? "" : "s");
+    if(breakSymmetry && reportLabelledCount){
+        fprintf(stderr, "This corresponds to %llu labelled thrackle embedding%s.\n",
+                labelled, labelled == 1 ? "" : "s");
+    }
+}
+
+//=============== Extending embeddings ===========================
+
+void invalidExtendedThrackle(){
+    fprintf(stderr, "Embedding %llu in %s is not an embedding of a subgraph of the input graph -- exiting!\n",
+            extendedThrackles + 1, extendFileName);
+    exit(EXIT_FAILURE);
+}
+
+/* Finds the neighbours of each vertex in extendCode, and checks that the
+ * vertices belong to the input graph and that every intersection has degree 4.
+ */
+void indexExtendedThrackle(){
+    int i, position = 2;
+    int codeVertices = extendCode[0] + extendCode[1];
+    
+    if(extendCode[0] > nv || extendCode[1] > intersectionCount){
+        invalidExtendedThrackle();
+    }
+    extendRotation = realloc(extendRotation, sizeof(int) * codeVertices);
+    extendDegree = realloc(extendDegree, sizeof(int) * codeVertices);
+    extendFirstHalfEdge = realloc(extendFirstHalfEdge, sizeof(int) * codeVertices);
+    if(codeVertices > 0 && (extendRotation == NULL || extendDegree == NULL ||
+            extendFirstHalfEdge == NULL)){
+        fprintf(stderr, "Insufficient memory for the embeddings in %s -- exiting!\n", extendFileName);
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < codeVertices; i++){
+        extendRotation[i] = position;
+        while(extendCode[position]){
+            if(extendCode[position] > codeVertices || extendCode[position] == i + 1){
+                invalidExtendedThrackle();
+            }
+            position++;
+        }
+        extendDegree[i] = position - extendRotation[i];
+        position++;
+        if(extendDegree[i] == 0 || (i >= extendCode[0] && extendDegree[i] != 4)){
+            invalidExtendedThrackle();
+        }
+    }
+}
+
+/* Returns the position of w in the rotation of v in extendCode, or -1 if w is
+ * not a neighbour of v.
+ */
+int findInExtendedRotation(int v, int w){
+    int i;
+    
+    for(i = 0; i < extendDegree[v]; i++){
+        if(extendCode[extendRotation[v] + i] == w + 1){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Follows the edge that leaves vertex v of the embedding in extendCode at the
+ * given position through its intersections, and returns the vertex at which
+ * it ends. An edge goes straight through an intersection. If edgeNumber is not
+ * negative, the half-edges on the way get this number.
+ */
+int followExtendedEdge(int v, int position, int edgeNumber){
+    int previous = v;
+    int current = extendCode[extendRotation[v] + position] - 1;
+    int steps = 0;
+    
+    while(TRUE){
+        if(edgeNumber >= 0){
+            EDGE *e = edges + extendFirstHalfEdge[previous] + position;
+            e->edgeNumber = e->inverse->edgeNumber = edgeNumber;
+        }
+        if(current < extendCode[0]){
+            return current;
+        }
+        int back = findInExtendedRotation(current, previous);
+        if(back < 0 || steps++ > extendCode[1]){
+            invalidExtendedThrackle();
+        }
+        position = (back + 2) % 4;
+        previous = current;
+        current = extendCode[extendRotation[current] + position] - 1;
+    }
+}
+
+/* Returns the number of the edge between v and w, or -1 if there is none.
+ */
+int findNumberedEdge(int v, int w){
+    int i;
+    
+    for(i = 0; i < edgeCount; i++){
+        if((numberedEdges[i][0] == v && numberedEdges[i][1] == w) ||
+                (numberedEdges[i][0] == w && numberedEdges[i][1] == v)){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Reads the first embedding in extendFileName and numbers the edges of the
+ * subgraph that it embeds first. The other edges keep their order as far as
+ * possible, but each of them should start at a vertex that is already
+ * embedded.
+ */
+void orderEdgesForExtension(){
+    int i, j, k;
+    int count = 0;
+    boolean isNumbered[edgeCount];
+    boolean embedded[nv];
+    int order[edgeCount][2];
+    
+    extendFile = fopen(extendFileName, "r");
+    if(extendFile == NULL){
+        fprintf(stderr, "Could not read the embeddings from %s -- exiting!\n", extendFileName);
+        exit(EXIT_FAILURE);
+    }
+    if(!readThrackleCode(&extendCode, &extendCodeSize, &extendCodeLength, extendFile)){
+        fprintf(stderr, "%s contains no embeddings -- exiting!\n", extendFileName);
+        exit(EXIT_FAILURE);
+    }
+    indexExtendedThrackle();
+    
+    for(i = 0; i < edgeCount; i++){
+        isNumbered[i] = FALSE;
+    }
+    for(i = 0; i < nv; i++){
+        embedded[i] = FALSE;
+    }
+    for(i = 0; i < extendCode[0]; i++){
+        for(j = 0; j < extendDegree[i]; j++){
+            k = findNumberedEdge(i, followExtendedEdge(i, j, -1));
+            if(k < 0){
+                invalidExtendedThrackle();
+            }
+            isNumbered[k] = TRUE;
+        }
+        embedded[i] = TRUE;
+    }
+    
+    //the edges of the subgraph
+    for(i = 0; i < edgeCount; i++){
+        if(isNumbered[i]){
+            order[count][0] = numberedEdges[i][0];
+            order[count][1] = numberedEdges[i][1];
+            count++;
+        }
+    }
+    extendedVertexCount = extendCode[0];
+    extendedEdgeCount = count;
+    extendedIntersectionCount = 0;
+    for(i = 0; i < count; i++){
+        for(j = 0; j < i; j++){
+            if(order[i][0] != order[j][0] && order[i][0] != order[j][1] &&
+                    order[i][1] != order[j][0] && order[i][1] != order[j][1]){
+                extendedIntersectionCount++;
+            }
+        }
+    }
+    
+    //the other edges, which are connected to the subgraph
+    while(count < edgeCount){
+        i = 0;
+        while(isNumbered[i] || !(embedded[numberedEdges[i][0]] || embedded[numberedEdges[i][1]])){
+            i++;
+        }
+        j = embedded[numberedEdges[i][0]] ? 0 : 1;
+        order[count][0] = numberedEdges[i][j];
+        order[count][1] = numberedEdges[i][1 - j];
+        embedded[numberedEdges[i][0]] = embedded[numberedEdges[i][1]] = TRUE;
+        isNumbered[i] = TRUE;
+        count++;
+    }
+    memcpy(numberedEdges, order, sizeof(int) * 2 * edgeCount);
+}
+
+/* Returns the vertex of the cross graph for vertex v of the embedding in
+ * extendCode.
+ */
+int extendedVertex(int v){
+    return v < extendCode[0] ? v : nv + v - extendCode[0];
+}
+
+/* Rebuilds the cross graph of the embedding in extendCode. The half-edges at
+ * each vertex are stored consecutively in clockwise order.
+ */
+void loadExtendedThrackle(){
+    int i, j;
+    int codeVertices = extendCode[0] + extendCode[1];
+    int halfEdges = 0;
+    
+    indexExtendedThrackle();
+    if(extendCode[0] != extendedVertexCount || extendCode[1] != extendedIntersectionCount){
+        invalidExtendedThrackle();
+    }
+    for(i = 0; i < codeVertices; i++){
+        extendFirstHalfEdge[i] = halfEdges;
+        halfEdges += extendDegree[i];
+    }
+    if(halfEdges != 2*(extendedEdgeCount + 2*extendedIntersectionCount)){
+        invalidExtendedThrackle();
+    }
+    
+    for(i = 0; i < nv + intersectionCount; i++){
+        firstedge[i] = NULL;
+        degree[i] = 0;
+    }
+    for(i = 0; i < codeVertices; i++){
+        int vertex = extendedVertex(i);
+        EDGE *first = edges + extendFirstHalfEdge[i];
+        for(j = 0; j < extendDegree[i]; j++){
+            int w = extendCode[extendRotation[i] + j] - 1;
+            int back = findInExtendedRotation(w, i);
+            if(back < 0){
+                invalidExtendedThrackle();
+            }
+            first[j].start = vertex;
+            first[j].end = extendedVertex(w);
+            first[j].next = first + (j + 1) % extendDegree[i];
+            first[j].prev = first + (j + extendDegree[i] - 1) % extendDegree[i];
+            first[j].inverse = edges + extendFirstHalfEdge[w] + back;
+        }
+        firstedge[vertex] = first;
+        degree[vertex] = extendDegree[i];
+    }
+    
+    //the edge numbers follow from the vertices that the edges connect
+    for(i = 0; i < extendCode[0]; i++){
+        for(j = 0; j < extendDegree[i]; j++){
+            int k = findNumberedEdge(i, followExtendedEdge(i, j, -1));
+            if(k < 0 || k >= extendedEdgeCount){
+                invalidExtendedThrackle();
+            }
+            followExtendedEdge(i, j, k);
+        }
+    }
+    
+    crossGraphEdgeCounter = halfEdges;
+    intersectionCounter = extendCode[1];
+    edgeCounter = extendedEdgeCount;
+    stabilizerSize = symmetryCount;
+}
+
+/* Adds the remaining edges to each embedding in extendFileName.
+ */
+void extendThrackles(){
+    do {
+        loadExtendedThrackle();
+        doNextEdge();
+        extendedThrackles++;
+    } while(!(justOne && numberOfThrackles > 0) &&
+            readThrackleCode(&extendCode, &extendCodeSize, &extendCodeLength, extendFile));
+    fclose(extendFile);
+}
+
+//=============== Forbidden subgraphs ===========================
+
+/* Tries to map the vertices of a subgraph with the given order and size from
+ * vertex onwards to unused vertices of the graph, such that each edge of the
+ * subgraph is mapped to an edge. The images are stored in witness. The search
+ * is fastest if each vertex that is not the first of its component is adjacent
+ * to an earlier one.
+ */
+boolean mapSubgraphVertex(GRAPH graph, ADJACENCY adj, int order, int size, int (*edges)[2],
+        int vertex, int *witness, boolean *used){
+    int i, j, parent = -1, vertexDegree = 0;
+    int candidates;
+    
+    if(vertex == order){
+        return TRUE;
+    }
+    //the image of vertex is a neighbour of the image of an earlier neighbour
+    for(i = 0; i < size; i++){
+        if(edges[i][0] == vertex || edges[i][1] == vertex){
+            vertexDegree++;
+        }
+        if(parent >= 0){
+            continue;
+        } else if(edges[i][0] == vertex && edges[i][1] < vertex){
+            parent = edges[i][1];
+        } else if(edges[i][1] == vertex && edges[i][0] < vertex){
+            parent = edges[i][0];
+        }
+    }
+    //without such a neighbour any vertex of the graph can be the image
+    candidates = parent < 0 ? graph[0][0] : adj[witness[parent]];
+    for(j = 0; j < candidates; j++){
+        int image = parent < 0 ? j + 1 : graph[witness[parent]][j];
+        boolean possible = !used[image] && adj[image] >= vertexDegree;
+        for(i = 0; i < size && possible; i++){
+            int u = edges[i][0];
+            int w = edges[i][1];
+            if(u == vertex && w < vertex){
+                possible = areAdjacent(graph, adj, image, witness[w]);
+            } else if(w == vertex && u < vertex){
+                possible = areAdjacent(graph, adj, image, witness[u]);
+            }
+        }
+        if(possible){
+            witness[vertex] = image;
+            used[image] = TRUE;
+            if(mapSubgraphVertex(graph, adj, order, size, edges, vertex + 1, witness, used)){
+                return TRUE;
+            }
+            used[image] = FALSE;
+        }
+    }
+    return FALSE;
+}
+
+/* Returns TRUE if the graph contains the subgraph with the given order, size
+ * and edges, and stores the vertices of the graph to which its vertices are
+ * mapped in witness.
+ */
+boolean containsSubgraph(GRAPH graph, ADJACENCY adj, int order, int size, int (*edges)[2],
+        int *witness){
+    int v;
+    boolean used[graph[0][0] + 1];
+    
+    if(order > graph[0][0]){
+        return FALSE;
+    }
+    for(v = 1; v <= graph[0][0]; v++){
+        used[v] = FALSE;
+    }
+    return mapSubgraphVertex(graph, adj, order, size, edges, 0, witness, used);
+}
+
+/* Returns the index of a forbidden subgraph that is contained in the graph and
+ * stores the vertices of the graph to which its vertices are mapped in
+ * witness, or returns -1 if the graph contains none of them.
+ */
+int findForbiddenSubgraph(GRAPH graph, ADJACENCY adj, int *witness){
+    int i, v;
+    int size = 0;
+    
+    for(v = 1; v <= graph[0][0]; v++){
+        size += adj[v];
+    }
+    size /= 2;
+    for(i = 0; i < FORBIDDEN_SUBGRAPH_COUNT; i++){
+        FORBIDDENSUBGRAPH *forbidden = forbiddenSubgraphs + i;
+        if(forbidden->size <= size && containsSubgraph(graph, adj, forbidden->order,
+                forbidden->size, forbidden->edges, witness)){
+            return i;
+        }
+    }
+    return -1;
+}
+
+void writeForbiddenSubgraph(FILE *f, int forbidden, int *witness){
+    int i;
+    
+    fprintf(f, "%s on the vertices", forbiddenSubgraphs[forbidden].name);
+    for(i = 0; i < forbiddenSubgraphs[forbidden].order; i++){
+        fprintf(f, " %d", witness[i]);
+    }
+}
+
+//=============== Results store ===========================
+
+/* Orders the vertices by their colour, their degree and the sorted colours of
+ * their neighbours.
+ */
+int compareKeyVertices(const void *a, const void *b){
+    int v = *(const int *) a;
+    int w = *(const int *) b;
+    int i;
+    
+    if(keyColour[v] != keyColour[w]){
+        return keyColour[v] < keyColour[w] ? -1 : 1;
+    }
+    if(keyAdj[v] != keyAdj[w]){
+        return keyAdj[v] < keyAdj[w] ? -1 : 1;
+    }
+    for(i = 0; i < keyAdj[v]; i++){
+        int cv = keyNeighbourColours[v*keyRowSize + i];
+        int cw = keyNeighbourColours[w*keyRowSize + i];
+        if(cv != cw){
+            return cv < cw ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/* Refines the colouring of keyGraph until vertices with the same colour have
+ * the same number of neighbours of each colour. The colours are numbered from 0
+ * in the order of compareKeyVertices, so the result does not depend on the
+ * labels of the vertices. Returns the number of colours.
+ */
+int refineColouring(int *colour){
+    int i, j, v, colours = 0, previousColours;
+    int n = keyGraph[0][0];
+    int vertices[n];
+    int refined[n + 1];
+    
+    keyColour = colour;
+    do {
+        previousColours = colours;
+        for(v = 1; v <= n; v++){
+            int *row = keyNeighbourColours + v*keyRowSize;
+            for(i = 0; i < keyAdj[v]; i++){
+                int c = colour[keyGraph[v][i]];
+                for(j = i; j > 0 && row[j - 1] > c; j--){
+                    row[j] = row[j - 1];
+                }
+                row[j] = c;
+            }
+            vertices[v - 1] = v;
+        }
+        qsort(vertices, n, sizeof(int), compareKeyVertices);
+        colours = 1;
+        refined[vertices[0]] = 0;
+        for(i = 1; i < n; i++){
+            if(compareKeyVertices(vertices + i - 1, vertices + i)){
+                colours++;
+            }
+            refined[vertices[i]] = colours - 1;
+        }
+        for(v = 1; v <= n; v++){
+            colour[v] = refined[v];
+        }
+    } while(colours > previousColours);
+    return colours;
+}
+
+/* Returns TRUE if v and w have the same neighbours apart from each other, so
+ * that exchanging them is an automorphism of keyGraph.
+ */
+boolean areTwins(int v, int w){
+    int i;
+    
+    if(keyAdj[v] != keyAdj[w]){
+        return FALSE;
+    }
+    for(i = 0; i < keyAdj[v]; i++){
+        if(keyGraph[v][i] != w && !areAdjacent(keyGraph, keyAdj, w, keyGraph[v][i])){
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Labels the vertices of keyGraph with their colours in the discrete colouring
+ * and keeps the sorted edges as keyCertificate if they are smaller than the
+ * certificate of the leaves before.
+ */
+void labelLeaf(int *colour){
+    int i, j, v, length = 0;
+    int n = keyGraph[0][0];
+    
+    for(v = 1; v <= n; v++){
+        for(i = 0; i < keyAdj[v]; i++){
+            int w = keyGraph[v][i];
+            int code;
+            if(w < v){
+                continue;
+            }
+            code = colour[v] < colour[w] ? colour[v]*n + colour[w] : colour[w]*n + colour[v];
+            for(j = length; j > 0 && keyLeafCertificate[j - 1] > code; j--){
+                keyLeafCertificate[j] = keyLeafCertificate[j - 1];
+            }
+            keyLeafCertificate[j] = code;
+            length++;
+        }
+    }
+    
+    for(i = 0; keyLeaves > 0 && i < length; i++){
+        if(keyLeafCertificate[i] != keyCertificate[i]){
+            break;
+        }
+    }
+    if(keyLeaves == 0 || (i < length && keyLeafCertificate[i] < keyCertificate[i])){
+        memcpy(keyCertificate, keyLeafCertificate, sizeof(int) * length);
+    }
+    keyLeaves++;
+}
+
+/* Refines the colouring and individualizes each vertex of the first colour
+ * with more than one vertex in turn, until the colouring is discrete. Twins
+ * give the same leaves, so only one of them is individualized.
+ */
+void searchCanonicalLabelling(int *colour){
+    int i, v, w, target;
+    int n = keyGraph[0][0];
+    int colours = refineColouring(colour);
+    int cellSize[colours];
+    int child[n + 1];
+    int tried[n];
+    int triedCount = 0;
+    
+    if(colours == n){
+        labelLeaf(colour);
+        return;
+    }
+    for(i = 0; i < colours; i++){
+        cellSize[i] = 0;
+    }
+    for(v = 1; v <= n; v++){
+        cellSize[colour[v]]++;
+    }
+    for(target = 0; cellSize[target] == 1; target++);
+    
+    for(v = 1; v <= n && keyLeaves < CANONICAL_MAX_LEAVES; v++){
+        if(colour[v] != target){
+            continue;
+        }
+        for(i = 0; i < triedCount && !areTwins(tried[i], v); i++);
+        if(i < triedCount){
+            continue;
+        }
+        tried[triedCount++] = v;
+        //v gets a colour just before the other vertices of its cell
+        for(w = 1; w <= n; w++){
+            child[w] = 2*colour[w] + 1;
+        }
+        child[v]--;
+        searchCanonicalLabelling(child);
+    }
+}
+
+/* Returns the key of the graph, which contains the order, the size and the
+ * sorted edges min*n + max of a canonical labelling with vertices 0 to n-1, or
+ * NULL if the graph has loops or multiple edges or the canonical labelling
+ * was given up. The key is allocated and should be freed by the caller.
+ */
+int *computeGraphKey(GRAPH graph, ADJACENCY adj){
+    int i, j, v;
+    int n = graph[0][0];
+    int size = 0, maxDegree = 1;
+    int colour[n + 1];
+    int *key = NULL;
+    
+    for(v = 1; v <= n; v++){
+        for(i = 0; i < adj[v]; i++){
+            if(graph[v][i] == v){
+                return NULL;
+            }
+            for(j = 0; j < i; j++){
+                if(graph[v][j] == graph[v][i]){
+                    return NULL;
+                }
+            }
+        }
+        size += adj[v];
+        if(adj[v] > maxDegree){
+            maxDegree = adj[v];
+        }
+        colour[v] = 0;
+    }
+    size /= 2;
+    
+    keyGraph = graph;
+    keyAdj = adj;
+    keyRowSize = maxDegree;
+    keyNeighbourColours = malloc(sizeof(int) * (n + 1) * maxDegree);
+    keyCertificate = malloc(sizeof(int) * (size + 1));
+    keyLeafCertificate = malloc(sizeof(int) * (size + 1));
+    if(keyNeighbourColours == NULL || keyCertificate == NULL || keyLeafCertificate == NULL){
+        fprintf(stderr, "Insufficient memory for canonical labelling -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    keyLeaves = 0;
+    searchCanonicalLabelling(colour);
+    
+    if(keyLeaves < CANONICAL_MAX_LEAVES){
+        key = malloc(sizeof(int) * (size + 2));
+        if(key == NULL){
+            fprintf(stderr, "Insufficient memory for canonical labelling -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        key[0] = n;
+        key[1] = size;
+        memcpy(key + 2, keyCertificate, sizeof(int) * size);
+    }
+    free(keyNeighbourColours);
+    free(keyCertificate);
+    free(keyLeafCertificate);
+    return key;
+}
+
+/* Builds the graph with the canonical labelling of the key of the result, its
+ * edges with the vertices in breadth-first order and its degrees.
+ */
+void prepareStoredGraph(STOREDRESULT *result){
+    int i, v, head = 0, tail = 0;
+    int n = result->key[0];
+    int size = result->key[1];
+    int maxDegrees[n + 1];
+    int queue[n];
+    
+    result->order = n;
+    result->size = size;
+    for(v = 1; v <= n; v++){
+        maxDegrees[v] = 0;
+    }
+    for(i = 0; i < size; i++){
+        maxDegrees[result->key[2 + i] / n + 1]++;
+        maxDegrees[result->key[2 + i] % n + 1]++;
+    }
+    prepareGraph(&(result->graph), &(result->adj), n, maxDegrees);
+    for(i = 0; i < size; i++){
+        addEdge(result->graph, result->adj, result->key[2 + i] / n + 1, result->key[2 + i] % n + 1);
+    }
+    
+    result->edges = malloc(sizeof(int[2]) * (size + 1));
+    result->breadthFirstLabel = malloc(sizeof(int) * (n + 1));
+    result->degrees = malloc(sizeof(int) * n);
+    if(result->edges == NULL || result->breadthFirstLabel == NULL || result->degrees == NULL){
+        fprintf(stderr, "Insufficient memory for results store -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(v = 1; v <= n; v++){
+        result->breadthFirstLabel[v] = -1;
+    }
+    for(v = 1; v <= n; v++){
+        if(result->breadthFirstLabel[v] >= 0){
+            continue;
+        }
+        result->breadthFirstLabel[v] = tail;
+        queue[tail++] = v;
+        while(head < tail){
+            int u = queue[head++];
+            for(i = 0; i < result->adj[u]; i++){
+                int w = result->graph[u][i];
+                if(result->breadthFirstLabel[w] < 0){
+                    result->breadthFirstLabel[w] = tail;
+                    queue[tail++] = w;
+                }
+            }
+        }
+    }
+    for(i = 0; i < size; i++){
+        result->edges[i][0] = result->breadthFirstLabel[result->key[2 + i] / n + 1];
+        result->edges[i][1] = result->breadthFirstLabel[result->key[2 + i] % n + 1];
+    }
+    for(v = 1; v <= n; v++){
+        int degree = result->adj[v];
+        for(i = v - 1; i > 0 && result->degrees[i - 1] < degree; i--){
+            result->degrees[i] = result->degrees[i - 1];
+        }
+        result->degrees[i] = degree;
+    }
+}
+
+void freeStoredGraph(STOREDRESULT *result){
+    freeGraph(result->graph, result->adj);
+    free(result->edges);
+    free(result->breadthFirstLabel);
+    free(result->degrees);
+}
+
+/* Returns FALSE if the first graph cannot be a subgraph of the second one
+ * because it is larger or its degrees do not fit.
+ */
+boolean degreesFit(STOREDRESULT *subgraph, STOREDRESULT *graph){
+    int i;
+    
+    if(subgraph->order > graph->order || subgraph->size > graph->size){
+        return FALSE;
+    }
+    for(i = 0; i < subgraph->order; i++){
+        if(subgraph->degrees[i] > graph->degrees[i]){
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Returns the index of the stored result with this key, or -1 if the graph
+ * is not stored. The caller should hold resultsMutex.
+ */
+int findStoredResult(int *key, unsigned long long int hash){
+    size_t slot;
+    
+    if(storedResultSlotCount == 0){
+        return -1;
+    }
+    slot = hash & (storedResultSlotCount - 1);
+    while(storedResultSlots[slot] >= 0){
+        STOREDRESULT *stored = storedResults + storedResultSlots[slot];
+        if(stored->hash == hash && stored->key[0] == key[0] && stored->key[1] == key[1] &&
+                memcmp(stored->key + 2, key + 2, sizeof(int) * key[1]) == 0){
+            return storedResultSlots[slot];
+        }
+        slot = (slot + 1) & (storedResultSlotCount - 1);
+    }
+    return -1;
+}
+
+/* The caller should hold resultsMutex.
+ */
+void growStoredResultSlots(){
+    size_t i, slot;
+    
+    free(storedResultSlots);
+    storedResultSlotCount = storedResultSlotCount == 0 ? 1024 : 2*storedResultSlotCount;
+    storedResultSlots = malloc(sizeof(int) * storedResultSlotCount);
+    if(storedResultSlots == NULL){
+        fprintf(stderr, "Insufficient memory for results store -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < storedResultSlotCount; i++){
+        storedResultSlots[i] = -1;
+    }
+    for(i = 0; i < (size_t) storedResultCount; i++){
+        slot = storedResults[i].hash & (storedResultSlotCount - 1);
+        while(storedResultSlots[slot] >= 0){
+            slot = (slot + 1) & (storedResultSlotCount - 1);
+        }
+        storedResultSlots[slot] = i;
+    }
+}
+
+/* Stores the result for the graph with this key, unless the store already has
+ * a result for it with a known number of embeddings or the number is not known
+ * either. Returns the index of the result, or -1 if nothing was stored. The
+ * caller should hold resultsMutex.
+ */
+int recordResult(int *key, long long int count, boolean thrackleable, int edgeOrder, double seconds){
+    unsigned long long int hash = hashCertificate(key, key[1] + 2);
+    int index = findStoredResult(key, hash);
+    STOREDRESULT *stored;
+    size_t slot;
+    
+    if(index >= 0 && (storedResults[index].count >= 0 || count < 0)){
+        return -1;
+    } else if(index < 0){
+        if(storedResultCount == storedResultCapacity){
+            storedResultCapacity = storedResultCapacity == 0 ? 256 : 2*storedResultCapacity;
+            storedResults = realloc(storedResults, sizeof(STOREDRESULT) * storedResultCapacity);
+            if(storedResults == NULL){
+                fprintf(stderr, "Insufficient memory for results store -- exiting!\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if(2*(storedResultCount + 1) > (int) storedResultSlotCount){
+            growStoredResultSlots();
+        }
+        index = storedResultCount++;
+        stored = storedResults + index;
+        stored->key = malloc(sizeof(int) * (key[1] + 2));
+        if(stored->key == NULL){
+            fprintf(stderr, "Insufficient memory for results store -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(stored->key, key, sizeof(int) * (key[1] + 2));
+        stored->hash = hash;
+        prepareStoredGraph(stored);
+        slot = hash & (storedResultSlotCount - 1);
+        while(storedResultSlots[slot] >= 0){
+            slot = (slot + 1) & (storedResultSlotCount - 1);
+        }
+        storedResultSlots[slot] = index;
+    }
+    stored = storedResults + index;
+    stored->count = count;
+    stored->thrackleable = thrackleable;
+    stored->edgeOrder = edgeOrder;
+    stored->seconds = seconds;
+    return index;
+}
+
+/* Appends the result to the file of the results store. The vertices of the
+ * canonical labelling are numbered from 1 there. The caller should hold
+ * resultsMutex.
+ */
+void writeStoredResult(STOREDRESULT *stored){
+    int i;
+    
+    fprintf(resultsFile, "%d %d", stored->order, stored->size);
+    for(i = 0; i < stored->size; i++){
+        fprintf(resultsFile, " %d-%d",
+                stored->key[2 + i] / stored->order + 1, stored->key[2 + i] % stored->order + 1);
+    }
+    if(stored->count < 0){
+        fprintf(resultsFile, " -");
+    } else {
+        fprintf(resultsFile, " %lld", stored->count);
+    }
+    fprintf(resultsFile, " %s %s %.3f\n", stored->thrackleable ? "yes" : "no",
+            stored->edgeOrder < 0 ? "-" : edgeOrderNames[stored->edgeOrder], stored->seconds);
+    fflush(resultsFile);
+}
+
+/* Reads a line of the results store, which contains the order and the size
+ * of a graph, its edges as v-w, the number of embeddings or -, yes or no, the
+ * edge order or - and the search time. The line does not need to use the
+ * canonical labelling. Returns FALSE if the line cannot be read.
+ */
+boolean readStoredResult(char *line){
+    int i, n, size, offset;
+    char countString[32], thrackleableString[4], edgeOrderString[16];
+    long long int count;
+    double seconds;
+    int edgeOrderOfResult = -1;
+    GRAPH graph;
+    ADJACENCY adj;
+    int *key;
+    
+    if(sscanf(line, "%d %d%n", &n, &size, &offset) != 2 || n < 1 || size < 0){
+        return FALSE;
+    }
+    line += offset;
+    int ends[size + 1][2];
+    int maxDegrees[n + 1];
+    for(i = 1; i <= n; i++){
+        maxDegrees[i] = 0;
+    }
+    for(i = 0; i < size; i++){
+        if(sscanf(line, " %d-%d%n", &ends[i][0], &ends[i][1], &offset) != 2 ||
+                ends[i][0] < 1 || ends[i][0] > n || ends[i][1] < 1 || ends[i][1] > n){
+            return FALSE;
+        }
+        line += offset;
+        maxDegrees[ends[i][0]]++;
+        maxDegrees[ends[i][1]]++;
+    }
+    if(sscanf(line, " %31s %3s %15s %lf", countString, thrackleableString,
+            edgeOrderString, &seconds) != 4){
+        return FALSE;
+    }
+    if(strcmp(countString, "-") == 0){
+        count = -1;
+    } else if(sscanf(countString, "%lld", &count) != 1 || count < 0){
+        return FALSE;
+    }
+    if(strcmp(edgeOrderString, "-") != 0){
+        for(i = 0; i < EDGE_ORDER_COUNT; i++){
+            if(strcmp(edgeOrderString, edgeOrderNames[i]) == 0){
+                edgeOrderOfResult = i;
+            }
+        }
+        if(edgeOrderOfResult < 0){
+            return FALSE;
+        }
+    }
+    if(strcmp(thrackleableString, "yes") != 0 && strcmp(thrackleableString, "no") != 0){
+        return FALSE;
+    }
+    
+    prepareGraph(&graph, &adj, n, maxDegrees);
+    for(i = 0; i < size; i++){
+        addEdge(graph, adj, ends[i][0], ends[i][1]);
+    }
+    key = computeGraphKey(graph, adj);
+    freeGraph(graph, adj);
+    //a graph without key cannot be looked up, so it is left out
+    if(key != NULL){
+        recordResult(key, count, strcmp(thrackleableString, "yes") == 0, edgeOrderOfResult, seconds);
+        free(key);
+    }
+    return TRUE;
+}
+
+/* Reads the results store if the file exists and opens it to append the
+ * results of new searches.
+ */
+void openResultsStore(){
+    FILE *f = fopen(resultsFileName, "r");
+    char *line = NULL;
+    size_t lineSize = 0;
+    int lineNumber = 0;
+    
+    if(f != NULL){
+        while(getline(&line, &lineSize, f) != -1){
+            lineNumber++;
+            if(line[0] == '#' || line[0] == '\n'){
+                continue;
+            }
+            if(!readStoredResult(line)){
+                fprintf(stderr, "Line %d of the results store %s cannot be read -- exiting!\n",
+                        lineNumber, resultsFileName);
+                exit(EXIT_FAILURE);
+            }
+        }
+        free(line);
+        fclose(f);
+    }
+    resultsFile = fopen(resultsFileName, "a");
+    if(resultsFile == NULL){
+        fprintf(stderr, "Could not open %s for the results store -- exiting!\n", resultsFileName);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Looks the graph up in the results store and stores in lookup what the store
+ * knows about it. If the graph itself is not stored, a stored graph without
+ * embedding that is contained in the graph is looked for, and then a stored
+ * thrackleable graph that contains the graph. The key of the graph is kept in
+ * graphKey for storeSearchResult. The array witness of lookup should have room
+ * for the vertices of the graph.
+ */
+void lookUpResult(GRAPH graph, ADJACENCY adj, RESULTLOOKUP *lookup){
+    int i, j;
+    STOREDRESULT query;
+    int witness[graph[0][0]];
+    
+    lookup->kind = RESULT_NOT_STORED;
+    free(graphKey);
+    graphKey = computeGraphKey(graph, adj);
+    if(graphKey == NULL){
+        return;
+    }
+    query.key = graphKey;
+    prepareStoredGraph(&query);
+    
+    pthread_mutex_lock(&resultsMutex);
+    i = findStoredResult(graphKey, hashCertificate(graphKey, graphKey[1] + 2));
+    if(i >= 0){
+        lookup->kind = RESULT_STORED;
+    }
+    for(j = 0; j < storedResultCount && lookup->kind == RESULT_NOT_STORED; j++){
+        STOREDRESULT *stored = storedResults + j;
+        if(!stored->thrackleable && degreesFit(stored, &query) &&
+                containsSubgraph(graph, adj, stored->order, stored->size, stored->edges, witness)){
+            lookup->kind = RESULT_STORED_SUBGRAPH;
+            i = j;
+        }
+    }
+    for(j = 0; j < storedResultCount && lookup->kind == RESULT_NOT_STORED; j++){
+        STOREDRESULT *stored = storedResults + j;
+        if(stored->thrackleable && degreesFit(&query, stored) &&
+                containsSubgraph(stored->graph, stored->adj, query.order, query.size, query.edges, witness)){
+            lookup->kind = RESULT_STORED_SUPERGRAPH;
+            i = j;
+        }
+    }
+    if(lookup->kind != RESULT_NOT_STORED){
+        STOREDRESULT *stored = storedResults + i;
+        lookup->entry = i + 1;
+        lookup->order = stored->order;
+        lookup->count = lookup->kind == RESULT_STORED_SUPERGRAPH ? -1 : stored->count;
+        lookup->thrackleable = stored->thrackleable;
+        lookup->edgeOrder = stored->edgeOrder;
+        lookup->seconds = stored->seconds;
+        if(lookup->kind == RESULT_STORED_SUBGRAPH){
+            //the witness is given in the order of the canonical labelling
+            for(j = 0; j < stored->order; j++){
+                lookup->witness[j] = witness[stored->breadthFirstLabel[j + 1]];
+            }
+        }
+    }
+    pthread_mutex_unlock(&resultsMutex);
+    
+    freeStoredGraph(&query);
 }
 
-//some macros for the stack in the next method
-#define INITSTACK(stack, maxsize) int top = 0; int stack[maxsize]
-#define PUSH(stack, value) stack[top++] = (value)
-#define POP(stack) stack[--top]
-#define STACKISEMPTY top==0
-#define STACKISNOTEMPTY top>0
+/* Returns TRUE if the search can be replaced by the result in lookup, and
+ * stores the numbers of embeddings the search would find in count and
+ * labelledCount. Embeddings cannot be written without a search, and with -s,
+ * --no-mirror or --non-iso only the absence of embeddings is known.
+ */
+boolean serveStoredResult(RESULTLOOKUP *lookup,
+        unsigned long long int *count, unsigned long long int *labelledCount){
+    if(lookup->kind == RESULT_NOT_STORED){
+        return FALSE;
+    } else if(!lookup->thrackleable){
+        *count = *labelledCount = 0;
+        return TRUE;
+    } else if(!countOnly && !censusMode){
+        return FALSE;
+    } else if(justOne){
+        *count = *labelledCount = 1;
+        return TRUE;
+    } else if(lookup->count >= 0 && !breakSymmetry && !nonIsomorphic){
+        *count = *labelledCount = lookup->count;
+        return TRUE;
+    }
+    return FALSE;
+}
 
-/**
- * Stores the edges in the array numberedEdges.
- * The edges are numbered such that for each 0 <= i < #edges we have that
- * the graph induced by the edges 0 up to i is connected.
+/* Adds the result of the search that just finished to the results store. The
+ * number of embeddings is only known if the search did not stop at the first
+ * one, and with -s or --no-mirror it is the labelled count.
  */
-void orderEdges(GRAPH graph, ADJACENCY adj){
-    int i, j;
-    edgeCount = 0;
-    boolean isStored[graph[0][0]+1][graph[0][0]+1];
-    boolean isVisited[graph[0][0]+1];
-    for(i = 1; i <= graph[0][0]; i++){
-        for(j = 1; j <= graph[0][0]; j++){
-            isStored[i][j] = FALSE;
+void storeSearchResult(double seconds){
+    long long int count = -1;
+    int index;
+    
+    if(graphKey == NULL){
+        return;
+    }
+    if(numberOfThrackles == 0){
+        count = 0;
+    } else if(!justOne){
+        count = breakSymmetry ? labelledNumberOfThrackles : numberOfThrackles;
+    }
+    pthread_mutex_lock(&resultsMutex);
+    index = recordResult(graphKey, count, numberOfThrackles > 0, usedEdgeOrder, seconds);
+    if(index >= 0){
+        writeStoredResult(storedResults + index);
+    }
+    pthread_mutex_unlock(&resultsMutex);
+}
+
+/* Writes where the result in lookup comes from.
+ */
+void writeResultOrigin(FILE *f, RESULTLOOKUP *lookup){
+    int i;
+    
+    if(lookup->kind == RESULT_STORED){
+        fprintf(f, "stored graph %d", lookup->entry);
+    } else if(lookup->kind == RESULT_STORED_SUBGRAPH){
+        fprintf(f, "contains stored graph %d on the vertices", lookup->entry);
+        for(i = 0; i < lookup->order; i++){
+            fprintf(f, " %d", lookup->witness[i]);
         }
-        isVisited[i] = FALSE;
+    } else if(lookup->kind == RESULT_STORED_SUPERGRAPH){
+        fprintf(f, "subgraph of stored graph %d", lookup->entry);
     }
+}
+
+//=============== Searching a graph ===========================
+
+/* Searches the thrackle embeddings of the given graph. In batch mode only a
+ * short summary is written for each graph and the search state is reused.
+ * Returns FALSE if the graph could not be handled.
+ */
+boolean thrackleGraph(GRAPH graph, ADJACENCY adj){
+    int i;
+    struct timespec start, end;
+    int givenSplitLevel = splitLevel;
     
-    INITSTACK(vertexStack, nv);
-    PUSH(vertexStack, 1); //push first vertex on the stack
-    isVisited[1] = TRUE;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
-    while(STACKISNOTEMPTY){
-        int currentVertex = POP(vertexStack);
-        for(j = 0; j < adj[currentVertex]; j++){
-            int currentNeighbour = graph[currentVertex][j];
-            if(!isVisited[currentNeighbour]){
-                PUSH(vertexStack, currentNeighbour);
-                isVisited[currentNeighbour] = TRUE;
+    if(batchMode){
+        fprintf(stderr, "Graph %d: ", graphsRead);
+    }
+    if(resultsFileName != NULL){
+        int witness[graph[0][0]];
+        RESULTLOOKUP lookup;
+        lookup.witness = witness;
+        lookUpResult(graph, adj, &lookup);
+        if(serveStoredResult(&lookup, &numberOfThrackles, &labelledNumberOfThrackles)){
+            isomorphismClassCount = 0;
+            servedResults++;
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if(batchMode){
+                double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+                fprintf(stderr, "%llu embedding%s, ",
+                        numberOfThrackles, numberOfThrackles == 1 ? "" : "s");
+                writeResultOrigin(stderr, &lookup);
+                fprintf(stderr, ", %.3fs\n", seconds);
+                batchNumberOfThrackles += numberOfThrackles;
+            } else if(lookup.kind == RESULT_STORED){
+                fprintf(stderr, "The results store has this graph as stored graph %d", lookup.entry);
+                if(lookup.count >= 0){
+                    fprintf(stderr, " with %lld thrackle embedding%s.\n",
+                            lookup.count, lookup.count == 1 ? "" : "s");
+                } else {
+                    fprintf(stderr, ", which is thrackleable.\n");
+                }
+                if(lookup.edgeOrder >= 0){
+                    fprintf(stderr, "It was searched in %.3fs with edge order %s.\n",
+                            lookup.seconds, edgeOrderNames[lookup.edgeOrder]);
+                }
+            } else if(lookup.kind == RESULT_STORED_SUBGRAPH){
+                fprintf(stderr, "The graph ");
+                writeResultOrigin(stderr, &lookup);
+                fprintf(stderr, ", so it has no thrackle embedding.\n");
+            } else {
+                fprintf(stderr, "The graph is a ");
+                writeResultOrigin(stderr, &lookup);
+                fprintf(stderr, ", so it is thrackleable.\n");
             }
-            if(!isStored[currentVertex][currentNeighbour]){
-                numberedEdges[edgeCount][0] = currentVertex - 1;
-                numberedEdges[edgeCount][1] = currentNeighbour - 1;
-                edgeCount++;
-                isStored[currentVertex][currentNeighbour] =
-                        isStored[currentNeighbour][currentVertex] = 
-                        TRUE;
+            return TRUE;
+        }
+    }
+    if(rejectForbiddenSubgraphs && !testEdgeOrder){
+        int witness[FORBIDDEN_MAX_ORDER];
+        int forbidden = findForbiddenSubgraph(graph, adj, witness);
+        if(forbidden >= 0){
+            numberOfThrackles = 0;
+            forbiddenSubgraphRejections++;
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if(batchMode){
+                double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+                fprintf(stderr, "0 embeddings, contains ");
+                writeForbiddenSubgraph(stderr, forbidden, witness);
+                fprintf(stderr, ", %.3fs\n", seconds);
+            } else {
+                fprintf(stderr, "The graph contains ");
+                writeForbiddenSubgraph(stderr, forbidden, witness);
+                fprintf(stderr, ", so it has no thrackle embedding.\n");
             }
+            return TRUE;
         }
     }
-    
-    //verify that the input graph was connected
-    for(i = 1; i <= graph[0][0]; i++){
-        if(!isVisited[i]){
-            fprintf(stderr, "Input graph was not connected -- exiting!\n");
-            exit(EXIT_FAILURE);
+    if(!orderEdges(graph, adj)){
+        return FALSE;
+    }
+    calculateCounts(graph, adj);
+    if(extendFileName != NULL){
+        orderEdgesForExtension();
+    }
+    if(breakSymmetry){
+        computeAutomorphisms(graph, adj);
+    }
+    if(!batchMode){
+        printStartSummary();
+    }
+    if(autoSplitParts > 0){
+        splitLevel = selectSplitLevel(autoSplitParts);
+        if(splitLevel < 2){
+            if(batchMode){
+                fprintf(stderr, "no split level%s", splittingEnabled ? ", " : "\n");
+            } else {
+                fprintf(stderr, "The graph has too few edges to select a split level.\n");
+            }
+        } else if(batchMode){
+            fprintf(stderr, "split level %d%s", splitLevel, splittingEnabled ? ", " : "\n");
+        } else {
+            fprintf(stderr, "Split level set to %d for %d parts.\n", splitLevel, autoSplitParts);
+        }
+        if(!splittingEnabled && coordinatorAddress == NULL){
+            if(breakSymmetry){
+                freeAutomorphisms();
+            }
+            splitLevel = givenSplitLevel;
+            return TRUE;
+        }
+    }
+    if((splittingEnabled || coordinatorAddress != NULL || deduplicateSplitStates) && splitLevel < 2){
+        splitLevel = 2*edgeCount/3;
+        if(!batchMode){
+            fprintf(stderr, "Split level automatically set to %d.\n", splitLevel);
+        }
+    } else if(splitLevel>=edgeCount){
+        fprintf(stderr, "Split level must be smaller than number of edges.\n");
+        if(breakSymmetry){
+            freeAutomorphisms();
+        }
+        return FALSE;
+    }
+    if(testEdgeOrder){
+        if(batchMode){
+            fprintf(stderr, "%d edge%s\n", edgeCount, edgeCount == 1 ? "" : "s");
+        } else {
+            fprintf(stderr, "Edges will be added in the following order:\n");
+        }
+        printEdgeNumbering();
+    } else {
+        DEBUGCALL(printEdgeNumbering());
+        selectSearch();
+        numberOfThrackles = 0;
+        labelledNumberOfThrackles = 0;
+        isomorphismClassCount = 0;
+        splitlevelCounter = 0;
+        for(i = 0; i < edgeCount; i++){
+            edgeEmbeddings[i] = 0;
+        }
+        if(estimateProbes > 0){
+            estimateSearch(estimateProbes);
+            if(breakSymmetry){
+                freeAutomorphisms();
+            }
+            return TRUE;
+        } else if(coordinatorAddress != NULL){
+            coordinateSearch();
+        } else if(workerAddress != NULL){
+            workForCoordinator();
+        } else if(threadCount > 1){
+            startTimer();
+            startThreadedThrackling();
+            stopTimer();
+        } else {
+            allocateGraphSearchState();
+            if(resumeFileName != NULL && !resumeSearch()){
+                fprintf(stderr, "The search was already finished.\n");
+            } else {
+                for(i = 0; i < edgeCount; i++){
+                    edgeNodes[i] = 0;
+                }
+                searcherNodes[0] = edgeNodes;
+                searcherThrackles[0] = &numberOfThrackles;
+                searcherCount = 1;
+                if(deduplicateSplitStates){
+                    prepareSplitStates();
+                    splitNodeHandler = deduplicateSplitState;
+                }
+                startTimer();
+                if(extendFileName != NULL){
+                    extendThrackles();
+                } else {
+                    startThrackling();
+                }
+                stopTimer();
+                if(deduplicateSplitStates){
+                    splitNodeHandler = NULL;
+                    clearSplitStates();
+                }
+                if(checkpointFileName != NULL){
+                    writeCheckpoint(TRUE);
+                }
+            }
+            freeGraphSearchState();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if(resultsFileName != NULL){
+            storeSearchResult((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9);
+        }
+        if(batchMode){
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+            fprintf(stderr, "%d vert%s, %d edge%s, %d intersection%s, ",
+                    nv, nv == 1 ? "ex" : "ices", edgeCount, edgeCount == 1 ? "" : "s",
+                    intersectionCount, intersectionCount == 1 ? "" : "s");
+            if(testCommonPart){
+                fprintf(stderr, "reached splitlevel %d time%s",
+                        splitlevelCounter, splitlevelCounter == 1 ? "" : "s");
+            } else {
+                fprintf(stderr, "%llu embedding%s",
+                        numberOfThrackles, numberOfThrackles == 1 ? "" : "s");
+                if(breakSymmetry && reportLabelledCount && !justOne){
+                    fprintf(stderr, " (%llu labelled)", labelledNumberOfThrackles);
+                }
+                if(nonIsomorphic){
+                    fprintf(stderr, ", %llu non-isomorphic", isomorphismClassCount);
+                }
+                if(deduplicateSplitStates){
+                    fprintf(stderr, ", %llu of %llu split states searched",
+                            splitStatesSearched, splitStatesSearched + splitStatesSkipped);
+                }
+            }
+            fprintf(stderr, ", %.3fs\n", seconds);
+            batchNumberOfThrackles += nonIsomorphic ? isomorphismClassCount : numberOfThrackles;
+        } else if(workerAddress == NULL){
+            //a worker only reports on its own units
+            printEndSummary();
         }
     }
     
-    if(edgeCount > 64){
-        fprintf(stderr, "Currently only supports up to 64 edges -- exiting!\n");
-        exit(EXIT_FAILURE);
+    if(breakSymmetry){
+        freeAutomorphisms();
     }
+    splitLevel = givenSplitLevel;
+    return TRUE;
 }
 
-void calculateCounts(GRAPH graph, ADJACENCY adj){
-    int i;
-    //number of vertices
-    nv = graph[0][0];
-    //number of intersections
-    intersectionCount = edgeCount*edgeCount + edgeCount;
-    for(i = 1; i <= nv; i++){
-        intersectionCount -= adj[i]*adj[i];
-    }
-    intersectionCount /= 2;
-}
+//=============== Census ===========================
 
-void printStartSummary(){
-    fprintf(stderr, "Input graph has %d %s and %d edge%s.\n",
-            nv, nv == 1 ? "vertex" : "vertices",
-            edgeCount, edgeCount==1 ? "" : "s");
-    fprintf(stderr, "A thrackle embedding for this graph will have %d intersection%s.\n",
-            intersectionCount, intersectionCount == 1 ? "" : "s");
+CENSUSENTRY *takeCensusGraph(){
+    CENSUSENTRY *entry = NULL;
+    
+    pthread_mutex_lock(&censusMutex);
+    while(censusTaken == censusRead && !censusInputFinished){
+        pthread_cond_wait(&censusGraphAvailable, &censusMutex);
+    }
+    if(censusTaken < censusRead){
+        entry = censusBuffer + censusTaken % censusBufferSize;
+        censusTaken++;
+    }
+    pthread_mutex_unlock(&censusMutex);
+    return entry;
 }
 
-void printEndSummary(){
-    if(testCommonPart){
-        fprintf(stderr, "Reached splitlevel %d time%s.\n", splitlevelCounter, splitlevelCounter == 1 ? "" : "s");
+void writeCensusEntry(CENSUSENTRY *entry){
+    fprintf(stdout, "%d %d %d ", entry->number, entry->order, entry->size);
+    if(entry->skipped){
+        fprintf(stdout, "? ");
+        if(breakSymmetry && reportLabelledCount){
+            fprintf(stdout, "? ");
+        }
+        fprintf(stdout, "?");
     } else {
-        fprintf(stderr, "Written %llu thrackle embedding%s.\n",
-                numberOfThrackles, numberOfThrackles == 1 ? "" : "s");
+        fprintf(stdout, "%llu ", entry->count);
+        if(breakSymmetry && reportLabelledCount){
+            fprintf(stdout, "%llu ", entry->labelledCount);
+        }
+        fprintf(stdout, "%s", entry->count ? "yes" : "no");
+        if(entry->count){
+            censusThrackleable++;
+        }
+    }
+    fprintf(stdout, " %.3f", entry->seconds);
+    if(entry->forbidden >= 0){
+        fprintf(stdout, " ");
+        writeForbiddenSubgraph(stdout, entry->forbidden, entry->witness);
+        forbiddenSubgraphRejections++;
+    } else if(entry->served){
+        fprintf(stdout, " ");
+        writeResultOrigin(stdout, &(entry->stored));
+        servedResults++;
     }
+    fprintf(stdout, "\n");
 }
 
-//=============== Writing thrackle_code of graph ===========================
+/* Marks the graph as done and writes all results that are next in line.
+ */
+void finishCensusGraph(CENSUSENTRY *entry){
+    pthread_mutex_lock(&censusMutex);
+    entry->done = TRUE;
+    while(censusWritten < censusTaken &&
+            censusBuffer[censusWritten % censusBufferSize].done){
+        CENSUSENTRY *next = censusBuffer + censusWritten % censusBufferSize;
+        writeCensusEntry(next);
+        next->done = FALSE;
+        censusWritten++;
+    }
+    pthread_cond_signal(&censusSlotAvailable);
+    pthread_mutex_unlock(&censusMutex);
+}
 
-void writeThrackleCodeChar(){
+void censusGraph(CENSUSENTRY *entry){
+    GRAPH graph;
+    ADJACENCY adj;
+    struct timespec start, end;
     int i;
-    EDGE *e, *elast;
     
-    //write the number of vertices
-    fputc(nv, stdout);
-    //write the number of intersections
-    fputc(ni, stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
-    for(i=0; i<nv + ni; i++){
-        e = elast = firstedge[i];
-        do {
-            fputc(e->end + 1, stdout);
-            e = e->next;
-        } while (e != elast);
-        fputc(0, stdout);
+    decodeMultiCode(entry->code, entry->length, &graph, &adj);
+    entry->order = graph[0][0];
+    entry->size = 0;
+    for(i = 1; i <= graph[0][0]; i++){
+        entry->size += adj[i];
+    }
+    entry->size /= 2;
+    
+    entry->served = FALSE;
+    if(resultsFileName != NULL){
+        if(entry->storedWitnessSize < entry->order){
+            free(entry->storedWitness);
+            entry->storedWitnessSize = entry->order;
+            entry->storedWitness = malloc(sizeof(int) * entry->storedWitnessSize);
+            if(entry->storedWitness == NULL){
+                fprintf(stderr, "Insufficient memory for census -- exiting!\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        entry->stored.witness = entry->storedWitness;
+        lookUpResult(graph, adj, &(entry->stored));
+        entry->served = serveStoredResult(&(entry->stored), &(entry->count), &(entry->labelledCount));
+    }
+    entry->forbidden = rejectForbiddenSubgraphs && !entry->served ?
+            findForbiddenSubgraph(graph, adj, entry->witness) : -1;
+    if(entry->served || entry->forbidden >= 0){
+        entry->skipped = FALSE;
+    } else {
+        entry->skipped = !orderEdges(graph, adj);
+    }
+    if(entry->forbidden >= 0){
+        entry->count = entry->labelledCount = 0;
+    }
+    if(!entry->skipped && !entry->served && entry->forbidden < 0){
+        calculateCounts(graph, adj);
+        if(breakSymmetry){
+            computeAutomorphisms(graph, adj);
+        }
+        selectSearch();
+        numberOfThrackles = 0;
+        labelledNumberOfThrackles = 0;
+        allocateGraphSearchState();
+        startThrackling();
+        freeGraphSearchState();
+        if(breakSymmetry){
+            freeAutomorphisms();
+        }
+        entry->count = numberOfThrackles;
+        entry->labelledCount = labelledNumberOfThrackles;
+    }
+    freeGraph(graph, adj);
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    entry->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+    if(resultsFileName != NULL && !entry->skipped && !entry->served && entry->forbidden < 0){
+        storeSearchResult(entry->seconds);
     }
 }
 
-void writeShort(unsigned short value){
-    if (fwrite(&value, sizeof (unsigned short), 1, stdout) != 1) {
-        fprintf(stderr, "fwrite() failed -- exiting!\n");
-        exit(-1);
+void *censusWorker(void *arg){
+    CENSUSENTRY *entry;
+    
+    while((entry = takeCensusGraph()) != NULL){
+        censusGraph(entry);
+        finishCensusGraph(entry);
     }
+    
+    return NULL;
 }
 
-void writeThrackleCodeShort(){
+/* Reads the graphs in the input and hands them to a pool of workers that each
+ * search one graph at a time.
+ */
+void runCensus(){
     int i;
-    EDGE *e, *elast;
-    
-    fputc(0, stdout);
-    //write the number of vertices
-    writeShort(nv);
-    //write the number of intersections
-    writeShort(ni);
+    pthread_t workers[jobCount];
     
+    censusBufferSize = 4*jobCount;
+    censusBuffer = malloc(sizeof(CENSUSENTRY) * censusBufferSize);
+    if(censusBuffer == NULL){
+        fprintf(stderr, "Insufficient memory for census -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < censusBufferSize; i++){
+        censusBuffer[i].code = NULL;
+        censusBuffer[i].codeSize = 0;
+        censusBuffer[i].storedWitness = NULL;
+        censusBuffer[i].storedWitnessSize = 0;
+        censusBuffer[i].done = FALSE;
+    }
     
-    for(i=0; i<nv+ni; i++){
-        e = elast = firstedge[i];
-        do {
-            writeShort(e->end + 1);
-            e = e->next;
-        } while (e != elast);
-        writeShort(0);
+    for(i = 0; i < jobCount; i++){
+        if(pthread_create(workers + i, NULL, censusWorker, NULL)){
+            fprintf(stderr, "Could not start thread -- exiting!\n");
+            exit(EXIT_FAILURE);
+        }
     }
-}
-
-void writeThrackleCode(){
-    static int first = TRUE;
     
-    if(first){
-        first = FALSE;
+    while(TRUE){
+        CENSUSENTRY *entry;
         
-        fprintf(stdout, ">>thrackle_code<<");
+        pthread_mutex_lock(&censusMutex);
+        while(censusRead - censusWritten >= censusBufferSize){
+            pthread_cond_wait(&censusSlotAvailable, &censusMutex);
+        }
+        pthread_mutex_unlock(&censusMutex);
+        
+        //this slot is not used by any worker
+        entry = censusBuffer + censusRead % censusBufferSize;
+        if(!readMultiCode(&(entry->code), &(entry->codeSize), &(entry->length), stdin)){
+            break;
+        }
+        entry->number = censusRead + 1;
+        
+        pthread_mutex_lock(&censusMutex);
+        censusRead++;
+        pthread_cond_signal(&censusGraphAvailable);
+        pthread_mutex_unlock(&censusMutex);
     }
     
-    if (nv + ni + 1 <= 255) {
-        writeThrackleCodeChar();
-    } else if (nv + ni + 1 <= 65535) {
-        writeThrackleCodeShort();
-    } else {
-        fprintf(stderr, "Graphs of that size are currently not supported -- exiting!\n");
-        exit(-1);
+    pthread_mutex_lock(&censusMutex);
+    censusInputFinished = TRUE;
+    pthread_cond_broadcast(&censusGraphAvailable);
+    pthread_mutex_unlock(&censusMutex);
+    
+    for(i = 0; i < jobCount; i++){
+        pthread_join(workers[i], NULL);
     }
+    for(i = 0; i < censusBufferSize; i++){
+        free(censusBuffer[i].code);
+        free(censusBuffer[i].storedWitness);
+    }
+    free(censusBuffer);
     
+    fprintf(stderr, "Read %d graph%s: %d %s thrackleable.\n",
+            censusRead, censusRead == 1 ? "" : "s",
+            censusThrackleable, censusThrackleable == 1 ? "is" : "are");
+    if(rejectForbiddenSubgraphs){
+        fprintf(stderr, "Rejected %llu graph%s that contain%s a forbidden subgraph.\n",
+                forbiddenSubgraphRejections, forbiddenSubgraphRejections == 1 ? "" : "s",
+                forbiddenSubgraphRejections == 1 ? "s" : "");
+    }
+    if(resultsFileName != NULL){
+        fprintf(stderr, "Took %llu result%s from the results store.\n",
+                servedResults, servedResults == 1 ? "" : "s");
+    }
 }
 
 //====================== USAGE =======================
@@ -716,11 +5363,20 @@ void help(char *name) {
     fprintf(stderr, "The program %s computes thrackle embeddings for a given graph.\n\n", name);
     fprintf(stderr, "Usage\n=====\n");
     fprintf(stderr, " %s [options]\n\n", name);
-    fprintf(stderr, "\nThis program can handle graphs up to %d vertices. Recompile if you need larger\n", MAXN);
-    fprintf(stderr, "graphs.\n\n");
+    fprintf(stderr, "\nThis program can handle connected graphs up to %d edges.\n\n", MAXE);
     fprintf(stderr, "Valid options\n=============\n");
     fprintf(stderr, "    -1, --one\n");
     fprintf(stderr, "       Stop the search when a thrackle embedding is found.\n");
+    fprintf(stderr, "    -s, --symmetry\n");
+    fprintf(stderr, "       Only write one thrackle embedding for each orbit under the automorphism\n");
+    fprintf(stderr, "       group of the input graph. Parts of the search that can only lead to\n");
+    fprintf(stderr, "       other embeddings in these orbits are pruned.\n");
+    fprintf(stderr, "    --no-mirror\n");
+    fprintf(stderr, "       Only write one of each pair of thrackle embeddings that are mirror\n");
+    fprintf(stderr, "       images of each other.\n");
+    fprintf(stderr, "    --labelled-count\n");
+    fprintf(stderr, "       When --symmetry or --no-mirror is used, also report the number of\n");
+    fprintf(stderr, "       thrackle embeddings that would have been found without these options.\n");
     fprintf(stderr, "    -m, --modulo r:n\n");
     fprintf(stderr, "       Split the generation in multiple parts. The generation is split into n\n");
     fprintf(stderr, "       parts and only part r is generated. The number n needs to be an integer\n");
@@ -729,12 +5385,159 @@ void help(char *name) {
     fprintf(stderr, "       Sets the level at which point the generation will be split. By default,\n");
     fprintf(stderr, "       this is set to 2/3 of the number of edges. The value l should lie\n");
     fprintf(stderr, "       between 2 and the number of edges.\n");
+    fprintf(stderr, "    --auto-split n\n");
+    fprintf(stderr, "       Select the split level for n parts with %d random probes of the search\n", AUTO_SPLIT_PROBES);
+    fprintf(stderr, "       tree. The predicted mean and largest part are written for each level,\n");
+    fprintf(stderr, "       and the shallowest level with at least n nodes is selected for which\n");
+    fprintf(stderr, "       the largest part is at most %.0f%% larger than an n-th of the search tree,\n", 100*(AUTO_SPLIT_IMBALANCE - 1));
+    fprintf(stderr, "       or else the level with the smallest largest part. Together\n");
+    fprintf(stderr, "       with -m r:n, part r is then generated with this level, which is the\n");
+    fprintf(stderr, "       same for all parts. Otherwise only the level is reported.\n");
+    fprintf(stderr, "    --split-dedup\n");
+    fprintf(stderr, "       Only search the subtree below a node at the split level if the partial\n");
+    fprintf(stderr, "       embedding at that node is not isomorphic to one that was searched\n");
+    fprintf(stderr, "       before, and otherwise add the counts of that subtree. The vertices that\n");
+    fprintf(stderr, "       still get edges keep their labels in these isomorphisms and mirror\n");
+    fprintf(stderr, "       images are allowed. The split level is set as for -m. This option\n");
+    fprintf(stderr, "       requires --count-only and cannot be combined with threads, splitting,\n");
+    fprintf(stderr, "       -s, --no-mirror, -1, --non-iso or --iterative.\n");
     fprintf(stderr, "    --test-common-part\n");
     fprintf(stderr, "       Runs the generation up to the splitting point and reports the number of\n");
     fprintf(stderr, "       times the splitting point is reached.\n");
+    fprintf(stderr, "    --edge-order name\n");
+    fprintf(stderr, "       Sets the strategy that determines the order in which the edges are added\n");
+    fprintf(stderr, "       to the thrackle. This order can have a large influence on the size of the\n");
+    fprintf(stderr, "       search tree. The possible strategies are:\n");
+    fprintf(stderr, "         dfs     handle the vertices depth-first and add all their edges\n");
+    fprintf(stderr, "                 (default)\n");
+    fprintf(stderr, "         bfs     handle the vertices breadth-first and add all their edges\n");
+    fprintf(stderr, "         degree  handle the reached vertex with the largest degree first\n");
+    fprintf(stderr, "         cycles  close cycles as early as possible\n");
+    fprintf(stderr, "         ears    repeatedly add a shortest ear\n");
+    fprintf(stderr, "         auto    estimate the size of the search tree for each strategy with\n");
+    fprintf(stderr, "                 %d random probes and use the smallest one\n", EDGE_ORDER_PROBES);
+    fprintf(stderr, "    --iterative\n");
+    fprintf(stderr, "       Use the search that keeps its choice points on an explicit stack and\n");
+    fprintf(stderr, "       undoes its changes with a trail instead of the recursive search. Both\n");
+    fprintf(stderr, "       searches give the same output, but the recursive search is faster.\n");
+    fprintf(stderr, "    --estimate k\n");
+    fprintf(stderr, "       Do not search the thrackle embeddings, but estimate the number of nodes\n");
+    fprintf(stderr, "       and leaves of the search tree and the number of embeddings with k\n");
+    fprintf(stderr, "       random probes, together with the time the search would take at the\n");
+    fprintf(stderr, "       speed of the probes. If no probe reaches an embedding, the number of\n");
+    fprintf(stderr, "       embeddings is reported as unknown, and an interval that would reach\n");
+    fprintf(stderr, "       below 0 is reported as an upper bound only.\n");
     fprintf(stderr, "    --test-edge-order\n");
     fprintf(stderr, "       Show the order in which the edges will be added to the thrackle and\n");
     fprintf(stderr, "       return.\n");
+    fprintf(stderr, "    --threads n\n");
+    fprintf(stderr, "       Use n threads for the search. Idle threads take over unexplored parts\n");
+    fprintf(stderr, "       of the search tree from working threads. The output is the same as\n");
+    fprintf(stderr, "       for a single thread, except that with -1 any embedding may be written.\n");
+    fprintf(stderr, "       This option cannot be combined with splitting.\n");
+    fprintf(stderr, "    --checkpoint file\n");
+    fprintf(stderr, "       Periodically write the state of the search to file, so that it can be\n");
+    fprintf(stderr, "       resumed with --resume after the process was stopped. When the search\n");
+    fprintf(stderr, "       is finished, this is recorded in the file.\n");
+    fprintf(stderr, "    --checkpoint-interval s\n");
+    fprintf(stderr, "       Write a checkpoint every s seconds. The default is %d.\n", checkpointInterval);
+    fprintf(stderr, "    --resume file\n");
+    fprintf(stderr, "       Continue the search from the checkpoint in file. The graph and the\n");
+    fprintf(stderr, "       options should be the same as for the original search. When the output\n");
+    fprintf(stderr, "       is appended to the original output, the embeddings written after the\n");
+    fprintf(stderr, "       checkpoint are removed from it first.\n");
+    fprintf(stderr, "    --progress s\n");
+    fprintf(stderr, "       Write a report of the progress of the search every s seconds, with the\n");
+    fprintf(stderr, "       number of nodes visited for each edge and in total, the number of nodes\n");
+    fprintf(stderr, "       per second and the number of embeddings found. Without threads also the\n");
+    fprintf(stderr, "       current depth and an estimate of the finished part of the search tree\n");
+    fprintf(stderr, "       are written. This report is also written when the process receives\n");
+    fprintf(stderr, "       SIGUSR1.\n");
+    fprintf(stderr, "    --progress-file file\n");
+    fprintf(stderr, "       Append the progress reports to file instead of writing them to stderr.\n");
+    fprintf(stderr, "       Without --progress a report is written every 60 seconds.\n");
+    fprintf(stderr, "    --count-only\n");
+    fprintf(stderr, "       Count the thrackle embeddings without writing them. For each k the\n");
+    fprintf(stderr, "       number of crossings of the k-th edge and the number of embeddings of the\n");
+    fprintf(stderr, "       first k edges that were found by the search are also written. With\n");
+    fprintf(stderr, "       splitting the counts for the edges before the split level are the\n");
+    fprintf(stderr, "       same in every part.\n");
+    fprintf(stderr, "    --non-iso\n");
+    fprintf(stderr, "       Only write embeddings that are not isomorphic to an embedding that was\n");
+    fprintf(stderr, "       written before, as with thrackle_non_iso -n. The first embedding of each\n");
+    fprintf(stderr, "       class is written, although with threads this can be a later one in the\n");
+    fprintf(stderr, "       order of the search. With splitting only the classes within one part\n");
+    fprintf(stderr, "       are compared. Together with --count-only the classes are counted.\n");
+    fprintf(stderr, "    --coordinator address\n");
+    fprintf(stderr, "       Search up to the split level and hand the subtree below each node at\n");
+    fprintf(stderr, "       that level as a unit to the workers that connect to address, which is\n");
+    fprintf(stderr, "       host:port for TCP and otherwise the path of a Unix domain socket. The\n");
+    fprintf(stderr, "       split level is given with --split-level or --auto-split, or else set\n");
+    fprintf(stderr, "       as for -m. When all units are finished, their embeddings are written in\n");
+    fprintf(stderr, "       the order of the search, so the output is the same as without workers.\n");
+    fprintf(stderr, "    --worker address\n");
+    fprintf(stderr, "       Search units for the coordinator at address until the search is\n");
+    fprintf(stderr, "       finished. The worker needs the same graph and the same -s, --no-mirror\n");
+    fprintf(stderr, "       and --count-only options as the coordinator.\n");
+    fprintf(stderr, "    --unit-directory dir\n");
+    fprintf(stderr, "       The directory in which the workers write the embeddings of their units\n");
+    fprintf(stderr, "       (default the current directory of the coordinator). It should be\n");
+    fprintf(stderr, "       reachable by the coordinator and all workers.\n");
+    fprintf(stderr, "    --unit-timeout s\n");
+    fprintf(stderr, "       A unit is handed out again if its worker did not report on it for s\n");
+    fprintf(stderr, "       seconds (default %d). Workers report every third of this time.\n", unitTimeout);
+    fprintf(stderr, "    --extend file\n");
+    fprintf(stderr, "       Read thrackle embeddings of a subgraph of the input graph from file, in\n");
+    fprintf(stderr, "       thrackle_code as written by this program, and only add the other edges\n");
+    fprintf(stderr, "       to each of them. The vertices of the subgraph should be the first\n");
+    fprintf(stderr, "       vertices of the input graph, and the file should contain all\n");
+    fprintf(stderr, "       embeddings of the subgraph to find all embeddings of the input graph.\n");
+    fprintf(stderr, "       A graph can so be grown edge by edge without searching the embeddings\n");
+    fprintf(stderr, "       of the common subgraph again.\n");
+    fprintf(stderr, "    --block-size n\n");
+    fprintf(stderr, "       Write the output in blocks of n bytes (default %d). Only the last block\n", DEFAULT_OUTPUT_BLOCK_SIZE);
+    fprintf(stderr, "       can be shorter. When n is a multiple of 4096 the output buffer is also\n");
+    fprintf(stderr, "       aligned to n, so that the output can go to a file opened with O_DIRECT.\n");
+    fprintf(stderr, "    --batch\n");
+    fprintf(stderr, "       Handle all graphs in the input instead of only the first one. The\n");
+    fprintf(stderr, "       embeddings of all graphs are written to one output stream and a short\n");
+    fprintf(stderr, "       summary is printed for each graph. Graphs that cannot be handled are\n");
+    fprintf(stderr, "       skipped.\n");
+    fprintf(stderr, "    --forbidden\n");
+    fprintf(stderr, "       Before searching a graph, check whether it contains one of the following\n");
+    fprintf(stderr, "       graphs without thrackle embedding as a subgraph: C4, the bowtie (two\n");
+    fprintf(stderr, "       triangles with a common vertex), the dumbbell (two triangles joined by\n");
+    fprintf(stderr, "       an edge) and theta(1,2,4) (three paths of lengths 1, 2 and 4 between\n");
+    fprintf(stderr, "       two vertices).\n");
+    fprintf(stderr, "       Such a graph has no thrackle embedding, so it is not searched and the\n");
+    fprintf(stderr, "       subgraph and its vertices are reported instead. In a census these are\n");
+    fprintf(stderr, "       written after the search time.\n");
+    fprintf(stderr, "    --results file\n");
+    fprintf(stderr, "       Keep the results of the searches in file, which is created if it does\n");
+    fprintf(stderr, "       not exist. Each line has the number of vertices and edges of a graph,\n");
+    fprintf(stderr, "       its edges as v-w in a canonical labelling, the number of thrackle\n");
+    fprintf(stderr, "       embeddings or - if the search stopped at the first one, yes or no, the\n");
+    fprintf(stderr, "       edge order that was used and the search time. Lines that start with #\n");
+    fprintf(stderr, "       are ignored. A graph is not searched if it is isomorphic to a stored\n");
+    fprintf(stderr, "       graph, if it contains a stored graph without thrackle embedding, or if\n");
+    fprintf(stderr, "       it is a subgraph of a stored thrackleable graph. Embeddings cannot be\n");
+    fprintf(stderr, "       taken from the store, so a thrackleable graph is only skipped with\n");
+    fprintf(stderr, "       --count-only or in a census, and with -s, --no-mirror or --non-iso only\n");
+    fprintf(stderr, "       together with -1. In a census the stored graph is written after the\n");
+    fprintf(stderr, "       search time. Graphs with loops or multiple edges are not stored. This\n");
+    fprintf(stderr, "       option cannot be combined with splitting, testing the edge order,\n");
+    fprintf(stderr, "       checkpoints, an estimate, --auto-split, --extend or a distributed search.\n");
+    fprintf(stderr, "    --census\n");
+    fprintf(stderr, "       Search all graphs in the input without writing the embeddings. For each\n");
+    fprintf(stderr, "       graph a line is written to stdout with the number of the graph in the\n");
+    fprintf(stderr, "       input, the number of vertices and edges, the number of thrackle\n");
+    fprintf(stderr, "       embeddings (followed by the labelled count if requested), yes or no\n");
+    fprintf(stderr, "       depending on whether the graph is thrackleable and the search time in\n");
+    fprintf(stderr, "       seconds. Graphs that cannot be handled have question marks instead of\n");
+    fprintf(stderr, "       counts. With -1 each search stops at the first embedding.\n");
+    fprintf(stderr, "    --jobs n\n");
+    fprintf(stderr, "       Search n graphs at the same time during a census. The results are still\n");
+    fprintf(stderr, "       written in the order of the input.\n");
     fprintf(stderr, "    -h, --help\n");
     fprintf(stderr, "       Print this help and return.\n");
 }
@@ -754,14 +5557,42 @@ int main(int argc, char *argv[]) {
         {"test-common-part", no_argument, NULL, 0},
         {"split-level", required_argument, NULL, 0},
         {"test-edge-order", no_argument, NULL, 0},
+        {"threads", required_argument, NULL, 0},
+        {"labelled-count", no_argument, NULL, 0},
+        {"no-mirror", no_argument, NULL, 0},
+        {"batch", no_argument, NULL, 0},
+        {"census", no_argument, NULL, 0},
+        {"jobs", required_argument, NULL, 0},
+        {"edge-order", required_argument, NULL, 0},
+        {"iterative", no_argument, NULL, 0},
+        {"checkpoint", required_argument, NULL, 0},
+        {"checkpoint-interval", required_argument, NULL, 0},
+        {"resume", required_argument, NULL, 0},
+        {"estimate", required_argument, NULL, 0},
+        {"progress", required_argument, NULL, 0},
+        {"progress-file", required_argument, NULL, 0},
+        {"count-only", no_argument, NULL, 0},
+        {"block-size", required_argument, NULL, 0},
+        {"non-iso", no_argument, NULL, 0},
+        {"auto-split", required_argument, NULL, 0},
+        {"coordinator", required_argument, NULL, 0},
+        {"worker", required_argument, NULL, 0},
+        {"unit-directory", required_argument, NULL, 0},
+        {"unit-timeout", required_argument, NULL, 0},
+        {"extend", required_argument, NULL, 0},
+        {"split-dedup", no_argument, NULL, 0},
+        {"forbidden", no_argument, NULL, 0},
+        {"results", required_argument, NULL, 0},
+        {"symmetry", no_argument, NULL, 's'},
         {"one", no_argument, NULL, '1'},
         {"modulo", required_argument, NULL, 'm'},
-        {"help", no_argument, NULL, 'h'}
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
     };
     int option_index = 0;
 
     char *splitting_string;
-    while ((c = getopt_long(argc, argv, "h1m:", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "h1sm:", long_options, &option_index)) != -1) {
         switch (c) {
             case 0:
                 switch (option_index) {
@@ -775,6 +5606,137 @@ int main(int argc, char *argv[]) {
                     case 2:
                         testEdgeOrder = TRUE;
                         break;
+                    case 3:
+                        threadCount = atoi(optarg);
+                        if(threadCount < 1){
+                            fprintf(stderr, "The number of threads should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 4:
+                        reportLabelledCount = TRUE;
+                        break;
+                    case 5:
+                        breakMirrorSymmetry = TRUE;
+                        break;
+                    case 6:
+                        batchMode = TRUE;
+                        break;
+                    case 7:
+                        censusMode = TRUE;
+                        break;
+                    case 8:
+                        jobCount = atoi(optarg);
+                        if(jobCount < 1){
+                            fprintf(stderr, "The number of jobs should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 9:
+                        if(strcmp(optarg, "auto") == 0){
+                            edgeOrder = EDGE_ORDER_AUTO;
+                        } else {
+                            for(edgeOrder = 0; edgeOrder < EDGE_ORDER_COUNT; edgeOrder++){
+                                if(strcmp(optarg, edgeOrderNames[edgeOrder]) == 0){
+                                    break;
+                                }
+                            }
+                            if(edgeOrder == EDGE_ORDER_COUNT){
+                                fprintf(stderr, "Unknown edge order %s.\n", optarg);
+                                usage(name);
+                                return EXIT_FAILURE;
+                            }
+                        }
+                        break;
+                    case 10:
+                        iterativeSearch = TRUE;
+                        break;
+                    case 11:
+                        checkpointFileName = optarg;
+                        break;
+                    case 12:
+                        checkpointInterval = atoi(optarg);
+                        if(checkpointInterval < 1){
+                            fprintf(stderr, "The checkpoint interval should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 13:
+                        resumeFileName = optarg;
+                        break;
+                    case 14:
+                        estimateProbes = atoi(optarg);
+                        if(estimateProbes < 1){
+                            fprintf(stderr, "The number of probes should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 15:
+                        progressInterval = atoi(optarg);
+                        if(progressInterval < 1){
+                            fprintf(stderr, "The progress interval should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 16:
+                        progressFileName = optarg;
+                        break;
+                    case 17:
+                        countOnly = TRUE;
+                        break;
+                    case 18:
+                        outputBlockSize = atoi(optarg);
+                        if(outputBlockSize < 1){
+                            fprintf(stderr, "The block size should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 19:
+                        nonIsomorphic = TRUE;
+                        break;
+                    case 20:
+                        autoSplitParts = atoi(optarg);
+                        if(autoSplitParts < 1){
+                            fprintf(stderr, "The number of parts should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 21:
+                        coordinatorAddress = optarg;
+                        break;
+                    case 22:
+                        workerAddress = optarg;
+                        break;
+                    case 23:
+                        unitDirectory = optarg;
+                        break;
+                    case 24:
+                        unitTimeout = atoi(optarg);
+                        if(unitTimeout < 1){
+                            fprintf(stderr, "The unit timeout should be positive.\n");
+                            usage(name);
+                            return EXIT_FAILURE;
+                        }
+                        break;
+                    case 25:
+                        extendFileName = optarg;
+                        break;
+                    case 26:
+                        deduplicateSplitStates = TRUE;
+                        break;
+                    case 27:
+                        rejectForbiddenSubgraphs = TRUE;
+                        break;
+                    case 28:
+                        resultsFileName = optarg;
+                        break;
                     default:
                         fprintf(stderr, "Illegal option.\n");
                         usage(name);
@@ -784,6 +5746,9 @@ int main(int argc, char *argv[]) {
             case '1':
                 justOne = TRUE;
                 break;
+            case 's':
+                breakGraphSymmetry = TRUE;
+                break;
             case 'm':
                 //modulo
                 splittingEnabled = TRUE;
@@ -820,33 +5785,195 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    if(threadCount > 1 && splittingEnabled){
+        fprintf(stderr, "Multiple threads cannot be combined with splitting.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(jobCount > 1 && !censusMode){
+        fprintf(stderr, "Multiple jobs can only be used for a census.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(censusMode && (threadCount > 1 || splittingEnabled || testEdgeOrder)){
+        fprintf(stderr, "A census cannot be combined with threads, splitting or testing the edge order.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(estimateProbes > 0 && (threadCount > 1 || splittingEnabled || batchMode ||
+            censusMode || checkpointFileName != NULL || resumeFileName != NULL)){
+        fprintf(stderr, "An estimate cannot be combined with threads, splitting, batches, a census or checkpoints.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if((checkpointFileName != NULL || resumeFileName != NULL) &&
+            (threadCount > 1 || batchMode || censusMode)){
+        fprintf(stderr, "Checkpoints cannot be combined with threads, batches or a census.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(autoSplitParts > 0 && (splitLevel != -1 || censusMode || estimateProbes > 0)){
+        fprintf(stderr, "Selecting the split level cannot be combined with a given split level, a census or an estimate.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(autoSplitParts > 0 && splittingEnabled && autoSplitParts != totalParts){
+        fprintf(stderr, "The split level should be selected for the same number of parts as for -m.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(nonIsomorphic && (censusMode || checkpointFileName != NULL || resumeFileName != NULL)){
+        fprintf(stderr, "Writing only non-isomorphic embeddings cannot be combined with a census or checkpoints.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(coordinatorAddress != NULL && workerAddress != NULL){
+        fprintf(stderr, "A process cannot be both a coordinator and a worker.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if((coordinatorAddress != NULL || workerAddress != NULL) && (threadCount > 1 ||
+            splittingEnabled || batchMode || censusMode || checkpointFileName != NULL ||
+            resumeFileName != NULL || estimateProbes > 0 || justOne || nonIsomorphic ||
+            testEdgeOrder || rejectForbiddenSubgraphs)){
+        fprintf(stderr, "A distributed search cannot be combined with threads, splitting, batches, a census,\n");
+        fprintf(stderr, "checkpoints, an estimate, -1, --non-iso, --forbidden or testing the edge order.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(extendFileName != NULL && (breakGraphSymmetry || breakMirrorSymmetry ||
+            threadCount > 1 || splittingEnabled || batchMode || censusMode ||
+            checkpointFileName != NULL || resumeFileName != NULL || estimateProbes > 0 ||
+            autoSplitParts > 0 || coordinatorAddress != NULL || workerAddress != NULL)){
+        fprintf(stderr, "Extending embeddings cannot be combined with -s, --no-mirror, threads, splitting,\n");
+        fprintf(stderr, "batches, a census, checkpoints, an estimate or a distributed search.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(deduplicateSplitStates && (!countOnly || breakGraphSymmetry || breakMirrorSymmetry ||
+            threadCount > 1 || splittingEnabled || justOne || nonIsomorphic || iterativeSearch ||
+            censusMode || checkpointFileName != NULL || resumeFileName != NULL ||
+            estimateProbes > 0 || autoSplitParts > 0 || extendFileName != NULL ||
+            coordinatorAddress != NULL || workerAddress != NULL)){
+        fprintf(stderr, "Deduplicating split states requires --count-only and cannot be combined with -s,\n");
+        fprintf(stderr, "--no-mirror, threads, splitting, -1, --non-iso, --iterative, a census,\n");
+        fprintf(stderr, "checkpoints, an estimate, --auto-split, --extend or a distributed search.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(resultsFileName != NULL && (splittingEnabled || testEdgeOrder ||
+            checkpointFileName != NULL || resumeFileName != NULL || estimateProbes > 0 ||
+            autoSplitParts > 0 || extendFileName != NULL || coordinatorAddress != NULL ||
+            workerAddress != NULL)){
+        fprintf(stderr, "A results store cannot be combined with splitting, testing the edge order,\n");
+        fprintf(stderr, "checkpoints, an estimate, --auto-split, --extend or a distributed search.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(workerAddress != NULL && autoSplitParts > 0){
+        fprintf(stderr, "The split level is selected by the coordinator.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(progressInterval > 0 && censusMode){
+        fprintf(stderr, "Progress reports cannot be combined with a census.\n");
+        usage(name);
+        return EXIT_FAILURE;
+    }
+    
+    if(progressFileName != NULL){
+        if(progressInterval == 0){
+            progressInterval = 60;
+        }
+        progressOutput = fopen(progressFileName, "a");
+        if(progressOutput == NULL){
+            fprintf(stderr, "Could not open %s for the progress reports.\n", progressFileName);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    searcherNodes = malloc(sizeof(unsigned long long int *) * threadCount);
+    searcherThrackles = malloc(sizeof(unsigned long long int *) * threadCount);
+    if(searcherNodes == NULL || searcherThrackles == NULL){
+        fprintf(stderr, "Insufficient memory for search state -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    breakSymmetry = breakGraphSymmetry || breakMirrorSymmetry;
+    
+    if(resultsFileName != NULL){
+        openResultsStore();
+    }
+    
+    openCodeOutput(&standardOutput, fileno(stdout), outputBlockSize);
+    atexit(closeStandardOutput);
+    thrackleOutput = &standardOutput;
+    
     /*=========== read graph ===========*/
 
-    unsigned short code[MAXCODELENGTH];
+    unsigned short *code = NULL;
+    int codeSize = 0;
     int length;
     GRAPH graph;
     ADJACENCY adj;
-    if (readMultiCode(code, &length, stdin)) {
-        decodeMultiCode(code, length, graph, adj);
-        orderEdges(graph, adj);
-        calculateCounts(graph, adj);
-        printStartSummary();
-        if(splittingEnabled && splitLevel < 2){
-            splitLevel = 2*edgeCount/3;
-            fprintf(stderr, "Split level automatically set to %d.\n", splitLevel);
-        } else if(splitLevel>=edgeCount){
-            fprintf(stderr, "Split level must be smaller than number of edges - exiting!\n");
-            return EXIT_FAILURE;
+    
+    if(censusMode){
+        runCensus();
+        return EXIT_SUCCESS;
+    }
+    
+    if(!batchMode){
+        if (readMultiCode(&code, &codeSize, &length, stdin)) {
+            decodeMultiCode(code, length, &graph, &adj);
+            free(code);
+            boolean thrackled = thrackleGraph(graph, adj);
+            freeGraph(graph, adj);
+            return thrackled ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else {
+            fprintf(stderr, "Input contains no graph -- exiting!\n");
         }
-        if(testEdgeOrder){
-            fprintf(stderr, "Edges will be added in the following order:\n");
-            printEdgeNumbering();
-            return EXIT_SUCCESS;
+        return EXIT_SUCCESS;
+    }
+    
+    while(readMultiCode(&code, &codeSize, &length, stdin)){
+        decodeMultiCode(code, length, &graph, &adj);
+        graphsRead++;
+        if(!thrackleGraph(graph, adj)){
+            graphsSkipped++;
         }
-        DEBUGCALL(printEdgeNumbering());
-        startThrackling();
-        printEndSummary();
-    } else {
-        fprintf(stderr, "Input contains no graph -- exiting!\n");
+        freeGraph(graph, adj);
+    }
+    free(code);
+    
+    fprintf(stderr, "Read %d graph%s", graphsRead, graphsRead == 1 ? "" : "s");
+    if(graphsSkipped){
+        fprintf(stderr, " (%d skipped)", graphsSkipped);
     }
+    if(forbiddenSubgraphRejections){
+        fprintf(stderr, " (%llu rejected by a forbidden subgraph)", forbiddenSubgraphRejections);
+    }
+    if(servedResults){
+        fprintf(stderr, " (%llu taken from the results store)", servedResults);
+    }
+    fprintf(stderr, ".\n");
+    if(!testEdgeOrder && !testCommonPart && (autoSplitParts == 0 || splittingEnabled)){
+        fprintf(stderr, "Written %llu thrackle embedding%s in total.\n",
+                batchNumberOfThrackles, batchNumberOfThrackles == 1 ? "" : "s");
+    }
+    
+    return EXIT_SUCCESS;
 }
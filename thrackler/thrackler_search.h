@@ -0,0 +1,841 @@
+/*
+ * Main developer: Nico Van Cleemput
+ * 
+ * Copyright (C) 2014 Nico Van Cleemput.
+ * Licensed under the GNU GPL, read the file LICENSE for details.
+ */
+
+/* The search for thrackle embeddings. This file is included by thrackler.c
+ * once for each width of the bitsets that contain the edges that still need
+ * to be intersected. Before including it, SEARCH_WIDTH should be defined as
+ * the number of bits in a bitset and bitset as the type of a bitset. The
+ * functions defined here get the suffix _SEARCH_WIDTH.
+ */
+
+#define WIDTHED_(name, width) name ## _ ## width
+#define WIDTHED__(name, width) WIDTHED_(name, width)
+#define WIDTHED(name) WIDTHED__(name, SEARCH_WIDTH)
+
+void WIDTHED(doNextEdge)();
+
+#define CAN_CROSS(e) (CONTAINS(nonIntersectedEdges, (e)->edgeNumber) && \
+        (!forwardCheck || faceDistance[halfEdgeFace[(e)->inverse - edges]] < remaining))
+
+/* Chooses the alternative at a choice point in intersectNextEdge during a
+ * random probe.
+ */
+void WIDTHED(probeIntersection)(EDGE *neighbouringEdge,
+        bitset nonIntersectedEdges, boolean forwardCheck, int remaining, int depth){
+    EDGE *e = neighbouringEdge;
+    int alternatives = 0;
+    int position = 0;
+    do {
+        if(CAN_CROSS(e)){
+            alternatives++;
+        }
+        e = e->inverse->prev;
+    } while (e != neighbouringEdge);
+    
+    int choice = probeChoice(depth, alternatives);
+    if(choice < 0){
+        return;
+    }
+    while(!CAN_CROSS(e) || choice-- > 0){
+        position++;
+        e = e->inverse->prev;
+    }
+    choiceFirst[depth] = choiceLast[depth] = position;
+}
+
+/* Labels the faces of the current cross graph from which a face containing
+ * targetVertex can be reached by crossing at most maxDistance edges that
+ * still need to be intersected, and stores the distance for each of them. All
+ * other faces get the label 0, which has an infinite distance.
+ */
+void WIDTHED(labelFaces)(bitset nonIntersectedEdges, int targetVertex, int maxDistance){
+    int i;
+    int faceCount = 1;
+    int head = 0, top = 0;
+    EDGE *e, *elast;
+    
+    for(i = 0; i < crossGraphEdgeCounter; i++){
+        halfEdgeFace[i] = 0;
+    }
+    faceDistance[0] = INT_MAX;
+    
+    //the faces around targetVertex
+    e = elast = firstedge[targetVertex];
+    do {
+        faceQueueDistance[top] = 0;
+        faceQueue[top++] = e->inverse;
+        e = e->next;
+    } while (e != elast);
+    
+    //breadth-first search in the dual
+    while(head < top){
+        int distance = faceQueueDistance[head];
+        EDGE *start = faceQueue[head++];
+        if(halfEdgeFace[start - edges]){
+            continue;
+        }
+        faceDistance[faceCount] = distance;
+        e = start;
+        do {
+            halfEdgeFace[e - edges] = faceCount;
+            if(distance < maxDistance && CONTAINS(nonIntersectedEdges, e->edgeNumber) &&
+                    !halfEdgeFace[e->inverse - edges]){
+                faceQueueDistance[top] = distance + 1;
+                faceQueue[top++] = e->inverse;
+            }
+            e = e->inverse->prev;
+        } while (e != start);
+        faceCount++;
+    }
+}
+
+void WIDTHED(intersectNextEdge)(EDGE *neighbouringEdge,
+        bitset nonIntersectedEdges, int currentEdge, int targetVertex){
+    edgeNodes[currentEdge]++;
+    if(IS_NOT_EMPTY(nonIntersectedEdges)){
+        //we still need to intersect some edges
+        
+        //forward check: the end of the edge should still be reachable
+        boolean forwardCheck = degree[targetVertex] > 0;
+        int remaining = 0;
+        if(forwardCheck){
+            remaining = SIZE(nonIntersectedEdges);
+            if(facesLabelledAt < 0){
+                WIDTHED(labelFaces)(nonIntersectedEdges, targetVertex, remaining);
+                facesLabelledAt = choiceDepth;
+            }
+            if(faceDistance[halfEdgeFace[neighbouringEdge - edges]] > remaining){
+                if(facesLabelledAt == choiceDepth){
+                    facesLabelledAt = -1;
+                }
+                return;
+            }
+        }
+        
+        EDGE *e, *elast;
+        int depth = choiceDepth++;
+        int position = 0;
+        if(depth < PROGRESS_DEPTH){
+            choiceSize[depth] = faceSize(neighbouringEdge);
+        }
+        if(probing){
+            WIDTHED(probeIntersection)(neighbouringEdge, nonIntersectedEdges,
+                    forwardCheck, remaining, depth);
+        }
+        e = elast = neighbouringEdge;
+        do {
+            if(CAN_CROSS(e) && position >= choiceFirst[depth]){
+                choicePath[depth] = position;
+                if(workRequested){
+                    donateWork();
+                }
+                DEBUGPRINT("Current edge: %d -- intersecting %d\n", currentEdge + 1, e->edgeNumber + 1);
+                //we still need to intersect this edge, so let us try it
+                EDGE *neighbouringEdgeNext = neighbouringEdge->next;
+                EDGE *eInverse = e->inverse;
+                //the new edges crossing the face
+                EDGE *newCrossingEdge = edges + crossGraphEdgeCounter++;
+                EDGE *newCrossingEdgeInverse = edges + crossGraphEdgeCounter++;
+                //the other new edges created by the intersection
+                EDGE *newEdgeAtE = edges + crossGraphEdgeCounter++;
+                EDGE *newEdgeAtEInverse = edges + crossGraphEdgeCounter++;
+                
+                int newVertex = nv + intersectionCounter++;
+                
+                newCrossingEdge->start = neighbouringEdge->start;
+                newCrossingEdge->end = newVertex;
+                newCrossingEdge->edgeNumber = currentEdge;
+                newCrossingEdge->inverse = newCrossingEdgeInverse;
+                newCrossingEdge->prev = neighbouringEdge;
+                newCrossingEdge->next = neighbouringEdgeNext;
+                
+                newCrossingEdgeInverse->start = newVertex;
+                newCrossingEdgeInverse->end = neighbouringEdge->start;
+                newCrossingEdgeInverse->edgeNumber = currentEdge;
+                newCrossingEdgeInverse->inverse = newCrossingEdge;
+                newCrossingEdgeInverse->prev = newEdgeAtEInverse;
+                newCrossingEdgeInverse->next = newEdgeAtE;
+                
+                newEdgeAtE->start = newVertex;
+                newEdgeAtE->end = e->start;
+                newEdgeAtE->edgeNumber = e->edgeNumber;
+                newEdgeAtE->inverse = e;
+                newEdgeAtE->prev = newCrossingEdgeInverse;
+                newEdgeAtE->next = newEdgeAtEInverse;
+                
+                newEdgeAtEInverse->start = newVertex;
+                newEdgeAtEInverse->end = eInverse->start;
+                newEdgeAtEInverse->edgeNumber = eInverse->edgeNumber;
+                newEdgeAtEInverse->inverse = eInverse;
+                newEdgeAtEInverse->prev = newEdgeAtE;
+                newEdgeAtEInverse->next = newCrossingEdgeInverse;
+                
+                e->inverse = newEdgeAtE;
+                eInverse->inverse = newEdgeAtEInverse;
+                neighbouringEdge->next = newCrossingEdge;
+                neighbouringEdgeNext->prev = newCrossingEdge;
+                e->end = newVertex;
+                eInverse->end = newVertex;
+                
+                //the parts of a split face keep its label
+                if(forwardCheck){
+                    halfEdgeFace[newEdgeAtE - edges] = halfEdgeFace[eInverse - edges];
+                    halfEdgeFace[newEdgeAtEInverse - edges] = halfEdgeFace[e - edges];
+                    halfEdgeFace[newCrossingEdge - edges] = halfEdgeFace[e - edges];
+                    halfEdgeFace[newCrossingEdgeInverse - edges] = halfEdgeFace[e - edges];
+                }
+                
+                firstedge[newVertex] = newCrossingEdgeInverse;
+                degree[newVertex] = 3;
+                degree[neighbouringEdge->start]++;
+                DEBUGCALL(printThrackle());
+                
+                //go to next intersection
+                WIDTHED(intersectNextEdge)(newEdgeAtE, MINUS(nonIntersectedEdges, e->edgeNumber),
+                        currentEdge, targetVertex);
+                
+                //backtracking
+                DEBUGPRINT("Backtracking with edge %d\n", currentEdge + 1);
+                intersectionCounter--;
+                crossGraphEdgeCounter-=4;
+                degree[neighbouringEdge->start]--;
+                e->inverse = eInverse;
+                eInverse->inverse = e;
+                neighbouringEdge->next = neighbouringEdgeNext;
+                neighbouringEdgeNext->prev = neighbouringEdge;
+                e->end = eInverse->start;
+                eInverse->end = e->start;
+            }
+            position++;
+            e = e->inverse->prev;
+        } while (e != elast && position <= choiceLast[depth]);
+        if(depth <= choiceRestricted){
+            finishChoice(depth);
+        }
+        choiceDepth--;
+        if(facesLabelledAt == depth){
+            facesLabelledAt = -1;
+        }
+    } else {
+        //we have intersected all edges: check that target vertex is in the current face
+        
+        if(degree[targetVertex]==0){
+            //vertex is not yet in the graph
+            EDGE* newEdge = edges + crossGraphEdgeCounter++;
+            EDGE* newEdgeInverse = edges + crossGraphEdgeCounter++;
+            
+            int startVertex = neighbouringEdge->start;
+            
+            newEdge->start = startVertex;
+            newEdge->end = targetVertex;
+            newEdge->edgeNumber = currentEdge;
+            
+            EDGE *nextEdge = neighbouringEdge->next;
+            neighbouringEdge->next = newEdge;
+            newEdge->prev = neighbouringEdge;
+            nextEdge->prev = newEdge;
+            newEdge->next = nextEdge;
+
+            newEdgeInverse->start = targetVertex;
+            newEdgeInverse->end = startVertex;
+            newEdgeInverse->next = newEdgeInverse->prev = newEdgeInverse;
+            newEdgeInverse->edgeNumber = currentEdge;
+
+            newEdge->inverse = newEdgeInverse;
+            newEdgeInverse->inverse = newEdge;
+            
+            degree[startVertex]++;
+            degree[targetVertex] = 1;
+            firstedge[targetVertex] = newEdgeInverse;
+            
+            //go to next edge
+            WIDTHED(doNextEdge)();
+            
+            //backtracking
+            degree[startVertex]--;
+            degree[targetVertex] = 0;
+            crossGraphEdgeCounter -= 2;
+            nextEdge->prev = neighbouringEdge;
+            neighbouringEdge->next = nextEdge;
+        } else {
+            EDGE *e, *elast;
+            e = elast = neighbouringEdge;
+            do {
+                if(e->end == targetVertex){
+                    break;
+                }
+                e = e->inverse->prev;
+            } while (e != elast);
+
+            if(e->end != targetVertex){
+                return;
+            }
+
+            //make connection with target vertex
+            EDGE* newEdge = edges + crossGraphEdgeCounter++;
+            EDGE* newEdgeInverse = edges + crossGraphEdgeCounter++;
+            
+            int startVertex = neighbouringEdge->start;
+            
+            newEdge->start = startVertex;
+            newEdge->end = targetVertex;
+            newEdge->edgeNumber = currentEdge;
+            
+            EDGE *nextEdge = neighbouringEdge->next;
+            neighbouringEdge->next = newEdge;
+            newEdge->prev = neighbouringEdge;
+            nextEdge->prev = newEdge;
+            newEdge->next = nextEdge;
+
+            newEdgeInverse->start = targetVertex;
+            newEdgeInverse->end = startVertex;
+            newEdgeInverse->edgeNumber = currentEdge;
+            
+            EDGE *nextEdgeInverse = e->inverse;
+            EDGE *prevEdgeInverse = nextEdgeInverse->prev;
+            nextEdgeInverse->prev = newEdgeInverse;
+            newEdgeInverse->next = nextEdgeInverse;
+            prevEdgeInverse->next = newEdgeInverse;
+            newEdgeInverse->prev = prevEdgeInverse;
+
+            newEdge->inverse = newEdgeInverse;
+            newEdgeInverse->inverse = newEdge;
+            
+            degree[startVertex]++;
+            degree[targetVertex]++;
+            
+            //go to next edge
+            WIDTHED(doNextEdge)();
+            
+            //backtrack
+            degree[startVertex]--;
+            degree[targetVertex]--;
+            crossGraphEdgeCounter -= 2;
+            nextEdge->prev = neighbouringEdge;
+            neighbouringEdge->next = nextEdge;
+            nextEdgeInverse->prev = prevEdgeInverse;
+            prevEdgeInverse->next = nextEdgeInverse;
+        }
+    }
+}
+
+void WIDTHED(doNextEdge)(){
+    if(breakSymmetry && !isSmallestInOrbitSoFar()){
+        return;
+    }
+    
+    if(edgeCounter == edgeCount){
+        //all edges are embedded
+        handleThrackle();
+        return;
+    }
+    
+    if(probing){
+        probeLevelWeight[edgeCounter] = probeWeight;
+        probeLevelNodes[edgeCounter] = probeNodes;
+    }
+    
+    if(edgeCounter == splitLevel){
+        if(splitNodeHandler != NULL){
+            splitNodeHandler();
+            return;
+        }
+        int inPart = splitlevelCounter%totalParts;
+        splitlevelCounter++;
+        if(testCommonPart || (inPart != currentPart)){
+            return;
+        }
+    }
+    
+    if(choiceDepth >= countFromDepth){
+        edgeEmbeddings[edgeCounter]++;
+    }
+    
+    int from, to;
+    
+    int currentEdge = edgeCounter++;
+    
+    from = numberedEdges[currentEdge][0];
+    to = numberedEdges[currentEdge][1];
+    
+    //weave edge through current thrackle
+    EDGE *e, *elast, newEdge;
+    
+    bitset nonIntersectedEdges = ALL_UP_TO(currentEdge-1);
+    
+    DEBUGPRINT("Next edge: %d (%d - %d)\n", currentEdge+1, from + 1, to + 1);
+    
+    //the vertex from will always have a degree different from 0
+    e = elast = firstedge[from];
+    do {
+        REMOVE(nonIntersectedEdges, e->edgeNumber);
+        DEBUGPRINT("Removing %d from non-intersected edges\n", e->edgeNumber + 1);
+        e = e->next;
+    } while (e != elast);
+    //the faces are labelled for this edge in its own arrays
+    int *outerHalfEdgeFace = halfEdgeFace;
+    int *outerFaceDistance = faceDistance;
+    int outerFacesLabelledAt = facesLabelledAt;
+    if(degree[to]>0){
+        e = elast = firstedge[to];
+        do {
+            REMOVE(nonIntersectedEdges, e->edgeNumber);
+            DEBUGPRINT("Removing %d from non-intersected edges\n", e->edgeNumber + 1);
+            e = e->next;
+        } while (e != elast);
+        halfEdgeFace = halfEdgeFaceLevels + faceLabelLevel*faceLabelSize;
+        faceDistance = faceDistanceLevels + faceLabelLevel*faceLabelSize;
+        faceLabelLevel++;
+        facesLabelledAt = -1;
+    }
+    
+    //add the first part of edge
+    int depth = choiceDepth++;
+    int position = 0;
+    if(depth < PROGRESS_DEPTH){
+        choiceSize[depth] = degree[from];
+    }
+    if(probing){
+        choiceFirst[depth] = choiceLast[depth] = probeChoice(depth, degree[from]);
+    }
+    e = elast = firstedge[from];
+    do {
+        if(position >= choiceFirst[depth]){
+            choicePath[depth] = position;
+            if(workRequested){
+                donateWork();
+            }
+            WIDTHED(intersectNextEdge)(e, nonIntersectedEdges, currentEdge, to);
+        }
+        position++;
+        e = e->next;
+    } while (e != elast && position <= choiceLast[depth]);
+    if(depth <= choiceRestricted){
+        finishChoice(depth);
+    }
+    choiceDepth--;
+    
+    if(degree[to]>0){
+        faceLabelLevel--;
+        halfEdgeFace = outerHalfEdgeFace;
+        faceDistance = outerFaceDistance;
+        facesLabelledAt = outerFacesLabelledAt;
+    }
+    
+    edgeCounter--;
+}
+
+//=============== Iterative search ===========================
+
+/* A choice point of the iterative search. This is either the choice of the
+ * edge after which the current edge leaves its first vertex, as in
+ * doNextEdge, or the choice of the next edge to intersect, as in
+ * intersectNextEdge. In the latter case elast is the edge that was passed as
+ * neighbouringEdge to intersectNextEdge.
+ */
+typedef struct {
+    boolean isIntersection;
+    int depth;
+    int position;
+    boolean started;
+    EDGE *e; /* the current alternative */
+    EDGE *elast;
+    
+    bitset nonIntersectedEdges;
+    int currentEdge;
+    int targetVertex;
+    boolean forwardCheck;
+    int remaining;
+    
+    //the state that is restored before the next alternative is tried
+    int edgeTrailMark;
+    int intTrailMark;
+    int crossGraphEdgeCounter;
+    int intersectionCounter;
+    
+    //the face labels of the enclosing edge if this edge has its own labels
+    boolean ownFaceLabels;
+    int *outerHalfEdgeFace;
+    int *outerFaceDistance;
+    int outerFacesLabelledAt;
+} WIDTHED(SEARCHFRAME);
+
+THREADLOCAL WIDTHED(SEARCHFRAME) *WIDTHED(searchStack);
+THREADLOCAL int WIDTHED(searchStackSize);
+
+static WIDTHED(SEARCHFRAME) *WIDTHED(pushFrame)(boolean isIntersection){
+    WIDTHED(SEARCHFRAME) *frame = WIDTHED(searchStack) + WIDTHED(searchStackSize)++;
+    frame->isIntersection = isIntersection;
+    frame->depth = choiceDepth++;
+    frame->position = 0;
+    frame->started = FALSE;
+    frame->edgeTrailMark = edgeTrailSize;
+    frame->intTrailMark = intTrailSize;
+    frame->crossGraphEdgeCounter = crossGraphEdgeCounter;
+    frame->intersectionCounter = intersectionCounter;
+    return frame;
+}
+
+static void WIDTHED(popFrame)(WIDTHED(SEARCHFRAME) *frame){
+    undoTrail(frame->edgeTrailMark, frame->intTrailMark);
+    crossGraphEdgeCounter = frame->crossGraphEdgeCounter;
+    intersectionCounter = frame->intersectionCounter;
+    if(frame->depth <= choiceRestricted){
+        finishChoice(frame->depth);
+    }
+    choiceDepth--;
+    if(frame->isIntersection){
+        if(facesLabelledAt == frame->depth){
+            facesLabelledAt = -1;
+        }
+    } else {
+        if(frame->ownFaceLabels){
+            faceLabelLevel--;
+            halfEdgeFace = frame->outerHalfEdgeFace;
+            faceDistance = frame->outerFaceDistance;
+            facesLabelledAt = frame->outerFacesLabelledAt;
+        }
+        edgeCounter--;
+    }
+    WIDTHED(searchStackSize)--;
+}
+
+/* Moves the choice point to its next alternative after undoing the changes
+ * made for the previous one. Returns FALSE if there are no more alternatives.
+ */
+static boolean WIDTHED(nextAlternative)(WIDTHED(SEARCHFRAME) *frame){
+    bitset nonIntersectedEdges = frame->nonIntersectedEdges;
+    boolean forwardCheck = frame->forwardCheck;
+    int remaining = frame->remaining;
+    int depth = frame->depth;
+    
+    if(frame->started){
+        undoTrail(frame->edgeTrailMark, frame->intTrailMark);
+        crossGraphEdgeCounter = frame->crossGraphEdgeCounter;
+        intersectionCounter = frame->intersectionCounter;
+    } else {
+        frame->started = TRUE;
+        if(frame->position >= choiceFirst[depth] &&
+                (!frame->isIntersection || CAN_CROSS(frame->e))){
+            return TRUE;
+        }
+    }
+    while(TRUE){
+        frame->position++;
+        frame->e = frame->isIntersection ? frame->e->inverse->prev : frame->e->next;
+        if(frame->e == frame->elast || frame->position > choiceLast[depth]){
+            return FALSE;
+        }
+        if(frame->position >= choiceFirst[depth] &&
+                (!frame->isIntersection || CAN_CROSS(frame->e))){
+            return TRUE;
+        }
+    }
+}
+
+/* Creates the choice point for the next edge, as doNextEdge does.
+ */
+static void WIDTHED(enterEdge)(){
+    if(breakSymmetry && !isSmallestInOrbitSoFar()){
+        return;
+    }
+    
+    if(edgeCounter == edgeCount){
+        //all edges are embedded
+        handleThrackle();
+        return;
+    }
+    
+    if(probing){
+        probeLevelWeight[edgeCounter] = probeWeight;
+        probeLevelNodes[edgeCounter] = probeNodes;
+    }
+    
+    if(edgeCounter == splitLevel){
+        if(splitNodeHandler != NULL){
+            splitNodeHandler();
+            return;
+        }
+        int inPart = splitlevelCounter%totalParts;
+        splitlevelCounter++;
+        if(testCommonPart || (inPart != currentPart)){
+            return;
+        }
+    }
+    
+    if(choiceDepth >= countFromDepth){
+        edgeEmbeddings[edgeCounter]++;
+    }
+    
+    int currentEdge = edgeCounter++;
+    int from = numberedEdges[currentEdge][0];
+    int to = numberedEdges[currentEdge][1];
+    EDGE *e, *elast;
+    
+    bitset nonIntersectedEdges = ALL_UP_TO(currentEdge-1);
+    
+    DEBUGPRINT("Next edge: %d (%d - %d)\n", currentEdge+1, from + 1, to + 1);
+    
+    e = elast = firstedge[from];
+    do {
+        REMOVE(nonIntersectedEdges, e->edgeNumber);
+        e = e->next;
+    } while (e != elast);
+    if(degree[to]>0){
+        e = elast = firstedge[to];
+        do {
+            REMOVE(nonIntersectedEdges, e->edgeNumber);
+            e = e->next;
+        } while (e != elast);
+    }
+    
+    WIDTHED(SEARCHFRAME) *frame = WIDTHED(pushFrame)(FALSE);
+    frame->e = frame->elast = firstedge[from];
+    frame->nonIntersectedEdges = nonIntersectedEdges;
+    frame->currentEdge = currentEdge;
+    frame->targetVertex = to;
+    frame->forwardCheck = FALSE;
+    if(frame->depth < PROGRESS_DEPTH){
+        choiceSize[frame->depth] = degree[from];
+    }
+    frame->ownFaceLabels = degree[to]>0;
+    if(frame->ownFaceLabels){
+        frame->outerHalfEdgeFace = halfEdgeFace;
+        frame->outerFaceDistance = faceDistance;
+        frame->outerFacesLabelledAt = facesLabelledAt;
+        halfEdgeFace = halfEdgeFaceLevels + faceLabelLevel*faceLabelSize;
+        faceDistance = faceDistanceLevels + faceLabelLevel*faceLabelSize;
+        faceLabelLevel++;
+        facesLabelledAt = -1;
+    }
+    if(probing){
+        choiceFirst[frame->depth] = choiceLast[frame->depth] =
+                probeChoice(frame->depth, degree[from]);
+    }
+}
+
+/* Creates the choice point for the next edge to intersect, or connects the
+ * current edge to its end if all edges are intersected, as intersectNextEdge
+ * does.
+ */
+static void WIDTHED(enterIntersection)(EDGE *neighbouringEdge,
+        bitset nonIntersectedEdges, int currentEdge, int targetVertex){
+    edgeNodes[currentEdge]++;
+    if(IS_NOT_EMPTY(nonIntersectedEdges)){
+        //forward check: the end of the edge should still be reachable
+        boolean forwardCheck = degree[targetVertex] > 0;
+        int remaining = 0;
+        if(forwardCheck){
+            remaining = SIZE(nonIntersectedEdges);
+            if(facesLabelledAt < 0){
+                WIDTHED(labelFaces)(nonIntersectedEdges, targetVertex, remaining);
+                facesLabelledAt = choiceDepth;
+            }
+            if(faceDistance[halfEdgeFace[neighbouringEdge - edges]] > remaining){
+                if(facesLabelledAt == choiceDepth){
+                    facesLabelledAt = -1;
+                }
+                return;
+            }
+        }
+        
+        WIDTHED(SEARCHFRAME) *frame = WIDTHED(pushFrame)(TRUE);
+        frame->e = frame->elast = neighbouringEdge;
+        frame->nonIntersectedEdges = nonIntersectedEdges;
+        frame->currentEdge = currentEdge;
+        frame->targetVertex = targetVertex;
+        frame->forwardCheck = forwardCheck;
+        frame->remaining = remaining;
+        if(frame->depth < PROGRESS_DEPTH){
+            choiceSize[frame->depth] = faceSize(neighbouringEdge);
+        }
+        if(probing){
+            WIDTHED(probeIntersection)(neighbouringEdge, nonIntersectedEdges,
+                    forwardCheck, remaining, frame->depth);
+        }
+        return;
+    }
+    
+    //we have intersected all edges: check that target vertex is in the current face
+    EDGE *e = NULL;
+    if(degree[targetVertex]>0){
+        EDGE *elast;
+        e = elast = neighbouringEdge;
+        do {
+            if(e->end == targetVertex){
+                break;
+            }
+            e = e->inverse->prev;
+        } while (e != elast);
+
+        if(e->end != targetVertex){
+            return;
+        }
+    }
+    
+    EDGE* newEdge = edges + crossGraphEdgeCounter++;
+    EDGE* newEdgeInverse = edges + crossGraphEdgeCounter++;
+    
+    int startVertex = neighbouringEdge->start;
+    
+    newEdge->start = startVertex;
+    newEdge->end = targetVertex;
+    newEdge->edgeNumber = currentEdge;
+    
+    EDGE *nextEdge = neighbouringEdge->next;
+    newEdge->prev = neighbouringEdge;
+    newEdge->next = nextEdge;
+    setEdgeOnTrail(&(neighbouringEdge->next), newEdge);
+    setEdgeOnTrail(&(nextEdge->prev), newEdge);
+
+    newEdgeInverse->start = targetVertex;
+    newEdgeInverse->end = startVertex;
+    newEdgeInverse->edgeNumber = currentEdge;
+    
+    newEdge->inverse = newEdgeInverse;
+    newEdgeInverse->inverse = newEdge;
+    
+    setIntOnTrail(degree + startVertex, degree[startVertex] + 1);
+    if(e == NULL){
+        //vertex is not yet in the graph
+        newEdgeInverse->next = newEdgeInverse->prev = newEdgeInverse;
+        firstedge[targetVertex] = newEdgeInverse;
+        setIntOnTrail(degree + targetVertex, 1);
+    } else {
+        //make connection with target vertex
+        EDGE *nextEdgeInverse = e->inverse;
+        EDGE *prevEdgeInverse = nextEdgeInverse->prev;
+        newEdgeInverse->next = nextEdgeInverse;
+        newEdgeInverse->prev = prevEdgeInverse;
+        setEdgeOnTrail(&(nextEdgeInverse->prev), newEdgeInverse);
+        setEdgeOnTrail(&(prevEdgeInverse->next), newEdgeInverse);
+        setIntOnTrail(degree + targetVertex, degree[targetVertex] + 1);
+    }
+    
+    //go to next edge
+    WIDTHED(enterEdge)();
+}
+
+/* Intersects the current alternative of a choice point created by
+ * enterIntersection.
+ */
+static void WIDTHED(crossEdge)(WIDTHED(SEARCHFRAME) *frame){
+    EDGE *e = frame->e;
+    EDGE *neighbouringEdge = frame->elast;
+    int currentEdge = frame->currentEdge;
+    
+    DEBUGPRINT("Current edge: %d -- intersecting %d\n", currentEdge + 1, e->edgeNumber + 1);
+    EDGE *neighbouringEdgeNext = neighbouringEdge->next;
+    EDGE *eInverse = e->inverse;
+    //the new edges crossing the face
+    EDGE *newCrossingEdge = edges + crossGraphEdgeCounter++;
+    EDGE *newCrossingEdgeInverse = edges + crossGraphEdgeCounter++;
+    //the other new edges created by the intersection
+    EDGE *newEdgeAtE = edges + crossGraphEdgeCounter++;
+    EDGE *newEdgeAtEInverse = edges + crossGraphEdgeCounter++;
+    
+    int newVertex = nv + intersectionCounter++;
+    
+    newCrossingEdge->start = neighbouringEdge->start;
+    newCrossingEdge->end = newVertex;
+    newCrossingEdge->edgeNumber = currentEdge;
+    newCrossingEdge->inverse = newCrossingEdgeInverse;
+    newCrossingEdge->prev = neighbouringEdge;
+    newCrossingEdge->next = neighbouringEdgeNext;
+    
+    newCrossingEdgeInverse->start = newVertex;
+    newCrossingEdgeInverse->end = neighbouringEdge->start;
+    newCrossingEdgeInverse->edgeNumber = currentEdge;
+    newCrossingEdgeInverse->inverse = newCrossingEdge;
+    newCrossingEdgeInverse->prev = newEdgeAtEInverse;
+    newCrossingEdgeInverse->next = newEdgeAtE;
+    
+    newEdgeAtE->start = newVertex;
+    newEdgeAtE->end = e->start;
+    newEdgeAtE->edgeNumber = e->edgeNumber;
+    newEdgeAtE->inverse = e;
+    newEdgeAtE->prev = newCrossingEdgeInverse;
+    newEdgeAtE->next = newEdgeAtEInverse;
+    
+    newEdgeAtEInverse->start = newVertex;
+    newEdgeAtEInverse->end = eInverse->start;
+    newEdgeAtEInverse->edgeNumber = eInverse->edgeNumber;
+    newEdgeAtEInverse->inverse = eInverse;
+    newEdgeAtEInverse->prev = newEdgeAtE;
+    newEdgeAtEInverse->next = newCrossingEdgeInverse;
+    
+    setEdgeOnTrail(&(e->inverse), newEdgeAtE);
+    setEdgeOnTrail(&(eInverse->inverse), newEdgeAtEInverse);
+    setEdgeOnTrail(&(neighbouringEdge->next), newCrossingEdge);
+    setEdgeOnTrail(&(neighbouringEdgeNext->prev), newCrossingEdge);
+    setIntOnTrail(&(e->end), newVertex);
+    setIntOnTrail(&(eInverse->end), newVertex);
+    
+    //the parts of a split face keep its label
+    if(frame->forwardCheck){
+        halfEdgeFace[newEdgeAtE - edges] = halfEdgeFace[eInverse - edges];
+        halfEdgeFace[newEdgeAtEInverse - edges] = halfEdgeFace[e - edges];
+        halfEdgeFace[newCrossingEdge - edges] = halfEdgeFace[e - edges];
+        halfEdgeFace[newCrossingEdgeInverse - edges] = halfEdgeFace[e - edges];
+    }
+    
+    firstedge[newVertex] = newCrossingEdgeInverse;
+    degree[newVertex] = 3;
+    setIntOnTrail(degree + neighbouringEdge->start, degree[neighbouringEdge->start] + 1);
+    DEBUGCALL(printThrackle());
+    
+    //go to next intersection
+    WIDTHED(enterIntersection)(newEdgeAtE, MINUS(frame->nonIntersectedEdges, e->edgeNumber),
+            currentEdge, frame->targetVertex);
+}
+
+/* Performs the same search as doNextEdge, and finds the embeddings in the same
+ * order, but keeps its choice points on an explicit stack and undoes its
+ * changes with the trail instead of returning from recursive calls.
+ */
+void WIDTHED(searchIteratively)(){
+    int maxDepth = edgeCount + intersectionCount + 1;
+    
+    WIDTHED(searchStack) = malloc(sizeof(WIDTHED(SEARCHFRAME)) * maxDepth);
+    edgeTrail = malloc(sizeof(EDGETRAILENTRY) * 4 * (edgeCount + intersectionCount));
+    intTrail = malloc(sizeof(INTTRAILENTRY) * (2*edgeCount + 3*intersectionCount + 1));
+    if(WIDTHED(searchStack) == NULL || edgeTrail == NULL || intTrail == NULL){
+        fprintf(stderr, "Insufficient memory for search state -- exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    WIDTHED(searchStackSize) = 0;
+    edgeTrailSize = 0;
+    intTrailSize = 0;
+    
+    WIDTHED(enterEdge)();
+    while(WIDTHED(searchStackSize) > 0){
+        WIDTHED(SEARCHFRAME) *frame = WIDTHED(searchStack) + WIDTHED(searchStackSize) - 1;
+        if(!WIDTHED(nextAlternative)(frame)){
+            WIDTHED(popFrame)(frame);
+            continue;
+        }
+        choicePath[frame->depth] = frame->position;
+        if(workRequested){
+            donateWork();
+        }
+        if(frame->isIntersection){
+            WIDTHED(crossEdge)(frame);
+        } else {
+            WIDTHED(enterIntersection)(frame->e, frame->nonIntersectedEdges,
+                    frame->currentEdge, frame->targetVertex);
+        }
+    }
+    
+    free(WIDTHED(searchStack));
+    free(edgeTrail);
+    free(intTrail);
+}
+
+#undef CAN_CROSS
+#undef WIDTHED
+#undef WIDTHED__
+#undef WIDTHED_
@@ -11,7 +11,7 @@
  * 
  * Compile with:
  *     
- *     cc -o thrackle2planar -O4 thrackle2planar.c
+ *     cc -o thrackle2planar -O4 -I../thrackler/shared thrackle2planar.c ../thrackler/shared/code_output.c
  * 
  */
 
@@ -20,6 +20,8 @@
 #include <getopt.h>
 #include <string.h>
 
+#include "code_output.h"
+
 #define MAXN 100
 #define MAXE (6*MAXN-12)     /* the maximum number of oriented edges in the cross graph */
 #define MAXCODELENGTH (MAXN+MAXE+4)
@@ -49,51 +51,53 @@ int nv; //number of vertices
 int ni; //number of intersections
 int ne; //number of (undirected) edges in the cross graph
 
+CODEOUTPUT output;
+
 //////////////////////////////////////////////////////////////////////////////
 
 //=============== Writing planar_code of graph ===========================
 
+/* The codes are encoded directly into the output buffer. Every half-edge of the
+ * cross graph is written once.
+ */
 void writePlanarCodeChar(){
     int i;
     EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(&output, 1 + nv + ni + ne);
     
     //write the number of vertices
-    fputc(nv + ni, stdout);
+    code = putCodeByte(code, nv + ni);
     
     for(i=0; i<nv + ni; i++){
         e = elast = firstedge[i];
         do {
-            fputc(e->end + 1, stdout);
+            code = putCodeByte(code, e->end + 1);
             e = e->next;
         } while (e != elast);
-        fputc(0, stdout);
-    }
-}
-
-void writeShort(unsigned short value){
-    if (fwrite(&value, sizeof (unsigned short), 1, stdout) != 1) {
-        fprintf(stderr, "fwrite() failed -- exiting!\n");
-        exit(-1);
+        code = putCodeByte(code, 0);
     }
+    finishCodeRecord(&output, code);
 }
 
 void writePlanarCodeShort(){
     int i;
     EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(&output, 1 + 2*(1 + nv + ni + ne));
     
-    fputc(0, stdout);
+    code = putCodeByte(code, 0);
     //write the number of vertices
-    writeShort(nv + ni);
+    code = putCodeShort(code, nv + ni);
     
     
     for(i=0; i<nv+ni; i++){
         e = elast = firstedge[i];
         do {
-            writeShort(e->end + 1);
+            code = putCodeShort(code, e->end + 1);
             e = e->next;
         } while (e != elast);
-        writeShort(0);
+        code = putCodeShort(code, 0);
     }
+    finishCodeRecord(&output, code);
 }
 
 void writePlanarCode(){
@@ -102,7 +106,7 @@ void writePlanarCode(){
     if(first){
         first = FALSE;
         
-        fprintf(stdout, ">>planar_code<<");
+        appendCodeOutput(&output, ">>planar_code<<", 15);
     }
     
     if (nv + ni + 1 <= 255) {
@@ -357,12 +361,15 @@ int main(int argc, char *argv[]) {
     
     /*=========== read graph ===========*/
 
+    openCodeOutput(&output, fileno(stdout), DEFAULT_OUTPUT_BLOCK_SIZE);
+
     unsigned short code[MAXCODELENGTH];
     int length;
     while (readThrackleCode(code, &length, stdin)) {
         decodeThrackleCode(code);
         writePlanarCode();
     }
+    closeCodeOutput(&output);
     
     return EXIT_SUCCESS;
 }
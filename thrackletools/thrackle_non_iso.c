@@ -11,7 +11,7 @@
  * 
  * Compile with:
  *     
- *     cc -o thrackle_non_iso -O4 thrackle_non_iso.c
+ *     cc -o thrackle_non_iso -Wall -O4 -I../thrackler/shared thrackle_non_iso.c ../thrackler/shared/code_output.c
  * 
  */
 
@@ -21,6 +21,8 @@
 #include <string.h>
 #include <malloc.h>
 
+#include "code_output.h"
+
 #define MAXN 200
 #define MAXE (6*MAXN-12)     /* the maximum number of oriented edges in the cross graph */
 #define MAXCODELENGTH (MAXN+MAXE+4)
@@ -51,6 +53,8 @@ int nv; //number of vertices
 int ni; //number of intersections
 int ne; //number of (undirected) edges in the cross graph
 
+CODEOUTPUT output;
+
 typedef struct t /* The data type used for thrackles in the list */ {
     int nv; //number of vertices
     int ni; //number of intersections
@@ -348,51 +352,51 @@ void getCanonicalForm(int certificate[], int *certificateLength){
 
 //=============== Writing thrackle_code of graph ===========================
 
+/* The codes are encoded directly into the output buffer. Every half-edge of the
+ * cross graph is written once.
+ */
 void writeThrackleCodeChar(){
     int i;
     EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(&output, 2 + nv + ni + ne);
     
     //write the number of vertices
-    fputc(nv, stdout);
+    code = putCodeByte(code, nv);
     //write the number of intersections
-    fputc(ni, stdout);
+    code = putCodeByte(code, ni);
     
     for(i=0; i<nv + ni; i++){
         e = elast = firstedge[i];
         do {
-            fputc(e->end + 1, stdout);
+            code = putCodeByte(code, e->end + 1);
             e = e->next;
         } while (e != elast);
-        fputc(0, stdout);
-    }
-}
-
-void writeShort(unsigned short value){
-    if (fwrite(&value, sizeof (unsigned short), 1, stdout) != 1) {
-        fprintf(stderr, "fwrite() failed -- exiting!\n");
-        exit(-1);
+        code = putCodeByte(code, 0);
     }
+    finishCodeRecord(&output, code);
 }
 
 void writeThrackleCodeShort(){
     int i;
     EDGE *e, *elast;
+    unsigned char *code = startCodeRecord(&output, 1 + 2*(2 + nv + ni + ne));
     
-    fputc(0, stdout);
+    code = putCodeByte(code, 0);
     //write the number of vertices
-    writeShort(nv);
+    code = putCodeShort(code, nv);
     //write the number of intersections
-    writeShort(ni);
+    code = putCodeShort(code, ni);
     
     
     for(i=0; i<nv+ni; i++){
         e = elast = firstedge[i];
         do {
-            writeShort(e->end + 1);
+            code = putCodeShort(code, e->end + 1);
             e = e->next;
         } while (e != elast);
-        writeShort(0);
+        code = putCodeShort(code, 0);
     }
+    finishCodeRecord(&output, code);
 }
 
 void writeThrackleCode(){
@@ -401,7 +405,7 @@ void writeThrackleCode(){
     if(first){
         first = FALSE;
         
-        fprintf(stdout, ">>thrackle_code<<");
+        appendCodeOutput(&output, ">>thrackle_code<<", 17);
     }
     
     if (nv + ni + 1 <= 255) {
@@ -673,6 +677,8 @@ int main(int argc, char *argv[]) {
     
     /*=========== read graph ===========*/
 
+    openCodeOutput(&output, fileno(stdout), DEFAULT_OUTPUT_BLOCK_SIZE);
+
     unsigned short code[MAXCODELENGTH];
     int length;
     int thracklesRead = 0;
@@ -704,6 +710,7 @@ int main(int argc, char *argv[]) {
             }
         }
     }
+    closeCodeOutput(&output);
     
     fprintf(stderr, "Read %d thrackle%s. Read %d unique thrackle%s.\n",
             thracklesRead, thracklesRead == 1 ? "" : "s",